@@ -0,0 +1,26 @@
+/* Функции программы с именами встроенных вызываются вместо них. Печатает 4 42 12 5 */
+int find(int a, int b)
+{
+	return a * 10 + b;
+}
+int next(int a)
+{
+	return a + 1;
+}
+int tostr(int a)
+{
+	return a * 3;
+}
+int chr(int a, int b)
+{
+	return a + b;
+}
+int main()
+{
+	print(next(3));
+	print(find(4, 2));
+	print(tostr(4));
+	print(chr(2, 3));
+	puts("");
+	return 0;
+}
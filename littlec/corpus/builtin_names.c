@@ -0,0 +1,24 @@
+/* Переменные с именами встроенных функций. Печатает 8 16 3 */
+int done, find;
+int locals()
+{
+	int next, strlen, chan;
+	next = 5;
+	done = next + 3;
+	strlen = done * 2;
+	chan = strlen;
+	print(done);
+	print(chan);
+	return 0;
+}
+int main()
+{
+	int field, join;
+	locals();
+	field = 1;
+	join = field + 2;
+	find = join;
+	print(find);
+	puts("");
+	return 0;
+}
@@ -0,0 +1,16 @@
+/* Контрольная сумма в стиле adler32 по псевдослучайным байтам */
+int a, b;
+int main()
+{
+	int i, x;
+	a = 1;
+	b = 0;
+	x = 12345;
+	for (i = 0; i < 100000; i = i + 1)
+	{
+		x = (x * 1103515245 + 12345) % 2147483647;
+		a = (a + x % 256) % 65521;
+		b = (b + a) % 65521;
+	}
+	return 0;
+}
@@ -0,0 +1,26 @@
+/* Самая длинная последовательность Коллатца */
+int best, best_start;
+int main()
+{
+	int start, n, steps;
+	for (start = 1; start < 3000; start = start + 1)
+	{
+		n = start;
+		steps = 0;
+		while (n != 1)
+		{
+			if (n % 2 == 0) {
+				n = n / 2;
+			}
+			else {
+				n = 3 * n + 1;
+			}
+			steps = steps + 1;
+		}
+		if (steps > best) {
+			best = steps;
+			best_start = start;
+		}
+	}
+	return 0;
+}
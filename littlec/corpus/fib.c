@@ -0,0 +1,24 @@
+/* Числа Фибоначчи по модулю и НОД соседних */
+int last, g;
+int gcd(int a, int b)
+{
+	if (b == 0) {
+		return a;
+	}
+	return gcd(b, a % b);
+}
+int main()
+{
+	int i, a, b, t;
+	a = 0;
+	b = 1;
+	for (i = 0; i < 50000; i = i + 1)
+	{
+		t = (a + b) % 1000000007;
+		a = b;
+		b = t;
+		g = g + gcd(a, b);
+	}
+	last = b;
+	return 0;
+}
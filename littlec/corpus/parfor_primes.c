@@ -0,0 +1,25 @@
+/* Простые числа перебором делителей в parfor: ядро для замера масштабирования по потокам */
+int count;
+int is_prime(int n)
+{
+	int d;
+	d = 2;
+	while (d * d <= n)
+	{
+		if (n % d == 0) {
+			return 0;
+		}
+		d = d + 1;
+	}
+	return 1;
+}
+int main()
+{
+	int n;
+	parfor (n = 2; n < 100000; n = n + 1) sum(count)
+	{
+		count = count + is_prime(n);
+	}
+	print(count);
+	return 0;
+}
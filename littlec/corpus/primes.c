@@ -0,0 +1,24 @@
+/* Количество простых чисел перебором делителей */
+int count;
+int is_prime(int n)
+{
+	int d;
+	d = 2;
+	while (d * d <= n)
+	{
+		if (n % d == 0) {
+			return 0;
+		}
+		d = d + 1;
+	}
+	return 1;
+}
+int main()
+{
+	int n;
+	for (n = 2; n < 20000; n = n + 1)
+	{
+		count = count + is_prime(n);
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Масштабирование parfor от 1 до N потоков на corpus/parfor_primes.c
+#
+# scaling.sh [littlec] [N]
+#
+# littlec - собранный интерпретатор, по умолчанию ./littlec
+# N - наибольшее число потоков, по умолчанию по числу ядер
+#
+# Сначала то же ядро обычным for (базовая линия без пула), потом parfor
+# с --threads=1, 2, 4, ... N. Ускорение считается от parfor с одним потоком.
+
+LITTLEC=${1:-./littlec}
+MAX=${2:-$(nproc)}
+DIR=$(cd "$(dirname "$0")" && pwd)
+KERNEL="$DIR/parfor_primes.c"
+SERIAL=$(mktemp "${TMPDIR:-/tmp}/serial.XXXXXX.c")
+trap 'rm -f "$SERIAL"' EXIT
+
+sed 's/parfor/for/; s/ sum(count)//' "$KERNEL" > "$SERIAL"
+
+# Секунды выполнения, вывод программы сверяется с ожидаемым
+run()
+{
+	start=$(date +%s.%N)
+	out=$("$@")
+	end=$(date +%s.%N)
+	if [ -n "$EXPECTED" ] && [ "$out" != "$EXPECTED" ]; then
+		echo "результат $out, ожидалось $EXPECTED" >&2
+		exit 1
+	fi
+	echo "$start $end" | awk '{ printf "%.3f", $2 - $1 }'
+}
+
+EXPECTED=$("$LITTLEC" "$SERIAL")
+printf "%-10s %8s\n" "for" "$(run "$LITTLEC" "$SERIAL")"
+
+base=
+threads=1
+while [ "$threads" -le "$MAX" ]; do
+	t=$(run "$LITTLEC" --threads="$threads" "$KERNEL") || exit 1
+	[ -z "$base" ] && base=$t
+	printf "%-10s %8s  x%s\n" "parfor/$threads" "$t" "$(echo "$base $t" | awk '{ printf "%.2f", $1 / $2 }')"
+	if [ "$threads" -lt "$MAX" ] && [ $((threads * 2)) -gt "$MAX" ]; then
+		threads=$MAX
+	else
+		threads=$((threads * 2))
+	fi
+done
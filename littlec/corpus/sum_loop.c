@@ -0,0 +1,16 @@
+/* Сумма по вложенным циклам */
+int sum;
+int main()
+{
+	int i, j, n;
+	n = 2000;
+	for (i = 0; i < n; i = i + 1)
+	{
+		for (j = 0; j < 100; j = j + 1)
+		{
+			sum = sum + j;
+		}
+		sum = sum + i;
+	}
+	return 0;
+}
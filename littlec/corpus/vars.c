@@ -0,0 +1,31 @@
+/* Девять локальных и девять глобальных переменных в горячем цикле */
+int g1, g2, g3, g4, g5, g6, g7, g8, total;
+int work(int a, int b, int c)
+{
+	int x1, x2, x3, x4, x5, x6, x7, x8, i;
+	x1 = a;
+	x2 = b;
+	x3 = c;
+	x4 = 0;
+	x5 = 1;
+	x6 = 2;
+	x7 = 3;
+	x8 = 4;
+	for (i = 0; i < 200; i = i + 1)
+	{
+		x4 = x4 + x1 * x5 - x2 + x3;
+		x1 = x1 + x8;
+		x2 = x2 + x7;
+		g8 = g8 + x6;
+	}
+	return x4 + g8;
+}
+int main()
+{
+	int k;
+	for (k = 0; k < 2000; k = k + 1)
+	{
+		total = total + work(k, k + 1, k + 2);
+	}
+	return 0;
+}
@@ -1,3 +1,12 @@
+/**
+ * Перечисления интерпретатора. Они в пространстве имен littlec, чтобы короткие
+ * INT, CHAR, END, SYNTAX не попадали в программу, которая встраивает LittleC
+ */
+#pragma once
+
+namespace littlec
+{
+
 /**
  * @brief Операторы
  */
@@ -17,7 +26,15 @@ enum tokens
 	BREAK,
 	EOL,    //end of line
 	FINISHED,
-	END
+	END,
+	PARFOR,
+	YIELD,
+	/// Тип локальной переменной-массива: ее значение - описатель в arrays
+	ARRAY,
+	/// 64-битный тип. Значение переменной - описатель ячейки в arrays
+	LONG,
+	/// Строка. Значение переменной - описатель ячейки в arrays, присваивание копирует текст
+	STR
 };
 
 /**
@@ -82,5 +99,176 @@ enum error_msg
 	NOT_STRING,
 	TOO_MANY_LVARS,
 	/// На ноль делить нельзя блеать
-	DIV_BY_ZERO
-};
\ No newline at end of file
+	DIV_BY_ZERO,
+	/// Кончились шаги из step_budget
+	STEPS_EXHAUSTED,
+	/// break или return из тела parfor
+	PARFOR_EXIT,
+	/// next() для генератора, который сам сейчас выполняется
+	GENERATOR_RUNNING,
+	/// yield в функции, вызванной не как генератор
+	YIELD_OUTSIDE,
+	/// Индексируется не массив
+	NOT_ARRAY,
+	/// Индекс за границами массива
+	INDEX_RANGE,
+	/// Размер массива не константа или слишком велик
+	ARRAY_SIZE,
+	/// Присваивание самому массиву, а не элементу
+	ARRAY_ASSIGN,
+	/// Переполнение в режиме checked_arithmetic
+	OVERFLOW,
+	/// long там, где можно только int: параметр функции, переменная reduction parfor
+	NOT_INT,
+	/// Не удалось выделить память, например стек генератора
+	NO_MEMORY
+};
+
+/**
+ * @brief Операции скомпилированного дерева выражений
+ */
+enum expr_ops
+{
+	/// Числовая константа
+	OP_CONST,
+	/// Чтение переменной по имени
+	OP_VAR,
+	/// Присваивание переменной
+	OP_ASSIGN,
+	/// Вызов пользовательской функции
+	OP_CALL,
+	/// Вызов функции хоста из natives, value - ее номер
+	OP_NATIVE,
+	/// Унарный минус
+	OP_NEG,
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_MOD,
+	OP_LOWER,
+	OP_LOWER_OR_EQUAL,
+	OP_GREATER,
+	OP_GREATER_OR_EQUAL,
+	OP_EQUAL,
+	OP_NOT_EQUAL,
+	/// Умножение на 2^value сдвигом влево
+	OP_SHIFT_LEFT,
+	/// Деление на 2^value сдвигом с поправкой для отрицательных
+	OP_DIV_POW2,
+	/// Остаток от деления на 2^value маской
+	OP_MOD_POW2,
+	/// Деление на константу умножением на магическое число
+	OP_DIV_MAGIC,
+	/// Остаток от деления на константу через OP_DIV_MAGIC
+	OP_MOD_MAGIC,
+	/// Глобальная переменная по индексу в global_vars
+	OP_GLOBAL,
+	/// Параметр подставляемой функции по номеру
+	OP_PARAM,
+	/// left ? right : other, тело подставленной функции с if
+	OP_SELECT,
+	/// Элемент массива: left - описатель, right - индекс
+	OP_INDEX,
+	/// Запись в элемент массива name: left - индекс, right - значение
+	OP_STORE,
+	/// OP_INDEX и OP_STORE, у которых индекс доказанно в границах массива
+	OP_INDEX_UNCHECKED,
+	OP_STORE_UNCHECKED,
+	/// Чтение переменной long по имени
+	OP_LONG_VAR,
+	/// Присваивание переменной long
+	OP_LONG_ASSIGN,
+	/// Поддерево left считается в 64 битах через eval_wide(), результат - в int
+	OP_WIDE,
+	/// Сложение, вычитание, умножение или минус (relop) с проверкой переполнения
+	OP_CHECKED,
+	/// Строковая константа: source - текст, value - длина
+	OP_TEXT,
+	/// Копирование строки right в переменную string
+	OP_STRING_ASSIGN,
+	/// name = concat(name, right) - дописать в конец на месте
+	OP_STRING_APPEND,
+	/*
+	 * Суперинструкции - слитые узлы для частых пар операций (см. --op-stats)
+	 */
+	/// name = name + value
+	OP_ADD_TO_VAR,
+	/// name = name + left->name
+	OP_ADD_VAR_TO_VAR,
+	/// name <relop> value
+	OP_COMPARE_VAR_CONST,
+	/// name <relop> left->name
+	OP_COMPARE_VAR_VAR,
+	/// Шаг и условие цикла for: left - OP_ADD_TO_VAR, right - сравнение той же переменной
+	OP_STEP_AND_TEST,
+	/// Количество операций
+	OP_COUNT
+};
+/**
+ * @brief Чем закончилось последнее чтение числа (instatus())
+ */
+enum input_status
+{
+	/// Число прочитано
+	INPUT_OK,
+	/// Ввод кончился
+	INPUT_EOF,
+	/// Следующее слово ввода не число, оно пропущено
+	INPUT_NOT_NUMBER
+};
+
+/**
+ * @brief Зачем сделан longjmp(execution_buffer)
+ */
+enum execution_jump
+{
+	/// Ошибка, после которой выполнять дальше нельзя
+	RUN_ABORTED = 1,
+	/// Программа дошла до end
+	RUN_ENDED
+};
+
+/**
+ * @brief Что сейчас с запуском программы в LittleC
+ */
+enum context_state
+{
+	/// Ничего не выполняется
+	CONTEXT_IDLE,
+	/// Программа выполняется на своем стеке (suspend_on_budget)
+	CONTEXT_RUNNING,
+	/// Шаги кончились, продолжить можно через resume()
+	CONTEXT_SUSPENDED,
+	/// Ждет ввода из wait_fd, продолжить через resume(), когда он появится
+	CONTEXT_WAITING,
+	/// Ждет в join() задачу join_task, продолжить через resume(), когда она закончится
+	CONTEXT_JOINING,
+	/// Ждет в send() или recv() канал blocked_on
+	CONTEXT_BLOCKED
+};
+
+/**
+ * @brief Как parfor собирает переменную из частичных результатов задач
+ */
+enum reduction_ops
+{
+	REDUCE_SUM,
+	REDUCE_MIN,
+	REDUCE_MAX
+};
+
+/**
+ * @brief Чем оптимизатор заменил цикл for целиком (см. vectorize_loop())
+ */
+enum loop_kernels
+{
+	/// t = t + a[i]
+	KERNEL_SUM,
+	/// if (a[i] < k) c = c + 1, и другие сравнения
+	KERNEL_COUNT,
+	/// c[i] = a[i] + b[i]
+	KERNEL_ADD
+};
+
+} // namespace littlec
@@ -0,0 +1,516 @@
+/**
+ * Ядра встроенных функций над массивами int: asum, adot, amin, amax, afill,
+ * acopy, aprefix, и циклов for, которые оптимизатор заменяет целиком
+ * (count_*, add). Вариант выбирается один раз при первом обращении по CPUID:
+ * AVX2, SSE4.1 или обычный цикл. Для массивов, которые сейчас делят задачи
+ * spawn() и parfor, есть отдельный набор shared() с атомарным доступом.
+ * Сложение и умножение идут по модулю 2^32, как в int-арифметике интерпретатора.
+ */
+#pragma once
+
+#include <cstring>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LITTLEC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace littlec
+{
+
+struct array_kernels
+{
+	const char *name;
+	int (*sum)(const int *a, int n);
+	int (*dot)(const int *a, const int *b, int n);
+	int (*min)(const int *a, int n); /* n > 0 */
+	int (*max)(const int *a, int n); /* n > 0 */
+	void (*fill)(int *a, int value, int n);
+	void (*copy)(int *to, const int *from, int n);
+	int (*prefix)(int *a, int n); /* a[i] = a[0] + ... + a[i], вернуть сумму всех */
+	int (*count_less)(const int *a, int n, int value);	  /* сколько a[i] < value */
+	int (*count_greater)(const int *a, int n, int value); /* сколько a[i] > value */
+	int (*count_equal)(const int *a, int n, int value);	  /* сколько a[i] == value */
+	void (*add)(int *to, const int *a, const int *b, int n); /* to[i] = a[i] + b[i] */
+
+	/**
+	 * Ядра для этого процессора
+	 */
+	static const array_kernels &selected()
+	{
+		static const array_kernels chosen = choose();
+		return chosen;
+	}
+	/**
+	 * Ядра для массивов, к которым одновременно обращаются несколько потоков:
+	 * каждый элемент читается и пишется одной атомарной операцией (relaxed),
+	 * поэтому одновременная запись в тот же элемент - не гонка данных
+	 */
+	static const array_kernels &shared()
+	{
+		static const array_kernels relaxed = {"relaxed", relaxed_sum, relaxed_dot, relaxed_min, relaxed_max,
+											  relaxed_fill, relaxed_copy, relaxed_prefix, relaxed_count_less,
+											  relaxed_count_greater, relaxed_count_equal, relaxed_add};
+		return relaxed;
+	}
+	static int load(const int *a)
+	{
+		return __atomic_load_n(a, __ATOMIC_RELAXED);
+	}
+	static void store(int *a, int value)
+	{
+		__atomic_store_n(a, value, __ATOMIC_RELAXED);
+	}
+
+	/* Обычные циклы - для процессоров без SSE4.1 и для хвостов векторных циклов */
+
+	static int scalar_sum(const int *a, int n)
+	{
+		uint32_t s = 0;
+
+		for (int i = 0; i < n; i++)
+			s += (uint32_t)a[i];
+		return (int)s;
+	}
+	static int scalar_dot(const int *a, const int *b, int n)
+	{
+		uint32_t s = 0;
+
+		for (int i = 0; i < n; i++)
+			s += (uint32_t)a[i] * (uint32_t)b[i];
+		return (int)s;
+	}
+	static int scalar_min(const int *a, int n)
+	{
+		int m = a[0];
+
+		for (int i = 1; i < n; i++)
+			m = a[i] < m ? a[i] : m;
+		return m;
+	}
+	static int scalar_max(const int *a, int n)
+	{
+		int m = a[0];
+
+		for (int i = 1; i < n; i++)
+			m = a[i] > m ? a[i] : m;
+		return m;
+	}
+	static void scalar_fill(int *a, int value, int n)
+	{
+		for (int i = 0; i < n; i++)
+			a[i] = value;
+	}
+	/// memmove из libc уже векторный, своих вариантов у copy нет
+	static void move(int *to, const int *from, int n)
+	{
+		memmove(to, from, (size_t)n * sizeof(int));
+	}
+	static int scalar_prefix(int *a, int n)
+	{
+		uint32_t s = 0;
+
+		for (int i = 0; i < n; i++)
+			a[i] = (int)(s += (uint32_t)a[i]);
+		return (int)s;
+	}
+	static int scalar_count_less(const int *a, int n, int value)
+	{
+		int count = 0;
+
+		for (int i = 0; i < n; i++)
+			count += a[i] < value;
+		return count;
+	}
+	static int scalar_count_greater(const int *a, int n, int value)
+	{
+		int count = 0;
+
+		for (int i = 0; i < n; i++)
+			count += a[i] > value;
+		return count;
+	}
+	static int scalar_count_equal(const int *a, int n, int value)
+	{
+		int count = 0;
+
+		for (int i = 0; i < n; i++)
+			count += a[i] == value;
+		return count;
+	}
+	static void scalar_add(int *to, const int *a, const int *b, int n)
+	{
+		for (int i = 0; i < n; i++)
+			to[i] = (int)((uint32_t)a[i] + (uint32_t)b[i]);
+	}
+
+	/* Атомарные поэлементные циклы для shared() */
+
+	static int relaxed_sum(const int *a, int n)
+	{
+		uint32_t s = 0;
+
+		for (int i = 0; i < n; i++)
+			s += (uint32_t)load(a + i);
+		return (int)s;
+	}
+	static int relaxed_dot(const int *a, const int *b, int n)
+	{
+		uint32_t s = 0;
+
+		for (int i = 0; i < n; i++)
+			s += (uint32_t)load(a + i) * (uint32_t)load(b + i);
+		return (int)s;
+	}
+	static int relaxed_min(const int *a, int n)
+	{
+		int m = load(a), x;
+
+		for (int i = 1; i < n; i++)
+			m = (x = load(a + i)) < m ? x : m;
+		return m;
+	}
+	static int relaxed_max(const int *a, int n)
+	{
+		int m = load(a), x;
+
+		for (int i = 1; i < n; i++)
+			m = (x = load(a + i)) > m ? x : m;
+		return m;
+	}
+	static void relaxed_fill(int *a, int value, int n)
+	{
+		for (int i = 0; i < n; i++)
+			store(a + i, value);
+	}
+	/// Как memmove: если to выше from, копируем с конца
+	static void relaxed_copy(int *to, const int *from, int n)
+	{
+		if (to < from)
+			for (int i = 0; i < n; i++)
+				store(to + i, load(from + i));
+		else
+			for (int i = n - 1; i >= 0; i--)
+				store(to + i, load(from + i));
+	}
+	static int relaxed_prefix(int *a, int n)
+	{
+		uint32_t s = 0;
+
+		for (int i = 0; i < n; i++)
+			store(a + i, (int)(s += (uint32_t)load(a + i)));
+		return (int)s;
+	}
+	static int relaxed_count_less(const int *a, int n, int value)
+	{
+		int count = 0;
+
+		for (int i = 0; i < n; i++)
+			count += load(a + i) < value;
+		return count;
+	}
+	static int relaxed_count_greater(const int *a, int n, int value)
+	{
+		int count = 0;
+
+		for (int i = 0; i < n; i++)
+			count += load(a + i) > value;
+		return count;
+	}
+	static int relaxed_count_equal(const int *a, int n, int value)
+	{
+		int count = 0;
+
+		for (int i = 0; i < n; i++)
+			count += load(a + i) == value;
+		return count;
+	}
+	static void relaxed_add(int *to, const int *a, const int *b, int n)
+	{
+		for (int i = 0; i < n; i++)
+			store(to + i, (int)((uint32_t)load(a + i) + (uint32_t)load(b + i)));
+	}
+#ifdef LITTLEC_X86_KERNELS
+	/* SSE4.1: по 4 элемента */
+
+	__attribute__((target("sse4.1"))) static int horizontal_sum(__m128i s)
+	{
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+		return _mm_cvtsi128_si32(s);
+	}
+	__attribute__((target("sse4.1"))) static int sse_sum(const int *a, int n)
+	{
+		__m128i s = _mm_setzero_si128();
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			s = _mm_add_epi32(s, _mm_loadu_si128((const __m128i *)(a + i)));
+		return (int)((uint32_t)horizontal_sum(s) + (uint32_t)scalar_sum(a + i, n - i));
+	}
+	__attribute__((target("sse4.1"))) static int sse_dot(const int *a, const int *b, int n)
+	{
+		__m128i s = _mm_setzero_si128();
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			s = _mm_add_epi32(s, _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(a + i)),
+												 _mm_loadu_si128((const __m128i *)(b + i))));
+		return (int)((uint32_t)horizontal_sum(s) + (uint32_t)scalar_dot(a + i, b + i, n - i));
+	}
+	__attribute__((target("sse4.1"))) static int sse_min(const int *a, int n)
+	{
+		__m128i m;
+		int i = 4, result;
+
+		if (n < 4)
+			return scalar_min(a, n);
+		m = _mm_loadu_si128((const __m128i *)a);
+		for (; i + 4 <= n; i += 4)
+			m = _mm_min_epi32(m, _mm_loadu_si128((const __m128i *)(a + i)));
+		m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0x4E));
+		m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0xB1));
+		result = _mm_cvtsi128_si32(m);
+		for (; i < n; i++)
+			result = a[i] < result ? a[i] : result;
+		return result;
+	}
+	__attribute__((target("sse4.1"))) static int sse_max(const int *a, int n)
+	{
+		__m128i m;
+		int i = 4, result;
+
+		if (n < 4)
+			return scalar_max(a, n);
+		m = _mm_loadu_si128((const __m128i *)a);
+		for (; i + 4 <= n; i += 4)
+			m = _mm_max_epi32(m, _mm_loadu_si128((const __m128i *)(a + i)));
+		m = _mm_max_epi32(m, _mm_shuffle_epi32(m, 0x4E));
+		m = _mm_max_epi32(m, _mm_shuffle_epi32(m, 0xB1));
+		result = _mm_cvtsi128_si32(m);
+		for (; i < n; i++)
+			result = a[i] > result ? a[i] : result;
+		return result;
+	}
+	__attribute__((target("sse4.1"))) static void sse_fill(int *a, int value, int n)
+	{
+		__m128i v = _mm_set1_epi32(value);
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_si128((__m128i *)(a + i), v);
+		scalar_fill(a + i, value, n - i);
+	}
+	/// Префиксная сумма внутри вектора двумя сдвигами, перенос - последний элемент
+	__attribute__((target("sse4.1"))) static int sse_prefix(int *a, int n)
+	{
+		__m128i carry = _mm_setzero_si128(), x;
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+		{
+			x = _mm_loadu_si128((const __m128i *)(a + i));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi32(x, carry);
+			_mm_storeu_si128((__m128i *)(a + i), x);
+			carry = _mm_shuffle_epi32(x, 0xFF);
+		}
+		if (i < n)
+			a[i] = (int)((uint32_t)a[i] + (uint32_t)_mm_cvtsi128_si32(carry));
+		else if (i)
+			return _mm_cvtsi128_si32(carry);
+		return i < n ? scalar_prefix(a + i, n - i) : 0;
+	}
+	/// Маска сравнения - это -1 в подходящих элементах, ее и вычитаем из счетчиков
+	__attribute__((target("sse4.1"))) static int sse_count_less(const int *a, int n, int value)
+	{
+		__m128i v = _mm_set1_epi32(value), count = _mm_setzero_si128();
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			count = _mm_sub_epi32(count, _mm_cmplt_epi32(_mm_loadu_si128((const __m128i *)(a + i)), v));
+		return horizontal_sum(count) + scalar_count_less(a + i, n - i, value);
+	}
+	__attribute__((target("sse4.1"))) static int sse_count_greater(const int *a, int n, int value)
+	{
+		__m128i v = _mm_set1_epi32(value), count = _mm_setzero_si128();
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			count = _mm_sub_epi32(count, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(a + i)), v));
+		return horizontal_sum(count) + scalar_count_greater(a + i, n - i, value);
+	}
+	__attribute__((target("sse4.1"))) static int sse_count_equal(const int *a, int n, int value)
+	{
+		__m128i v = _mm_set1_epi32(value), count = _mm_setzero_si128();
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			count = _mm_sub_epi32(count, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(a + i)), v));
+		return horizontal_sum(count) + scalar_count_equal(a + i, n - i, value);
+	}
+	__attribute__((target("sse4.1"))) static void sse_add(int *to, const int *a, const int *b, int n)
+	{
+		int i = 0;
+
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_si128((__m128i *)(to + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(a + i)),
+																_mm_loadu_si128((const __m128i *)(b + i))));
+		scalar_add(to + i, a + i, b + i, n - i);
+	}
+
+	/* AVX2: по 8 элементов */
+
+	__attribute__((target("avx2"))) static __m128i fold(__m256i x)
+	{
+		return _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+	}
+	__attribute__((target("avx2"))) static int avx2_sum(const int *a, int n)
+	{
+		__m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+		int i = 0;
+
+		for (; i + 16 <= n; i += 16)
+		{
+			s0 = _mm256_add_epi32(s0, _mm256_loadu_si256((const __m256i *)(a + i)));
+			s1 = _mm256_add_epi32(s1, _mm256_loadu_si256((const __m256i *)(a + i + 8)));
+		}
+		return (int)((uint32_t)horizontal_sum(fold(_mm256_add_epi32(s0, s1))) + (uint32_t)sse_sum(a + i, n - i));
+	}
+	__attribute__((target("avx2"))) static int avx2_dot(const int *a, const int *b, int n)
+	{
+		__m256i s = _mm256_setzero_si256();
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+			s = _mm256_add_epi32(s, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i *)(a + i)),
+													   _mm256_loadu_si256((const __m256i *)(b + i))));
+		return (int)((uint32_t)horizontal_sum(fold(s)) + (uint32_t)scalar_dot(a + i, b + i, n - i));
+	}
+	__attribute__((target("avx2"))) static int avx2_min(const int *a, int n)
+	{
+		__m256i m;
+		__m128i h;
+		int i = 8, result;
+
+		if (n < 8)
+			return sse_min(a, n);
+		m = _mm256_loadu_si256((const __m256i *)a);
+		for (; i + 8 <= n; i += 8)
+			m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i *)(a + i)));
+		h = _mm_min_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+		h = _mm_min_epi32(h, _mm_shuffle_epi32(h, 0x4E));
+		h = _mm_min_epi32(h, _mm_shuffle_epi32(h, 0xB1));
+		result = _mm_cvtsi128_si32(h);
+		for (; i < n; i++)
+			result = a[i] < result ? a[i] : result;
+		return result;
+	}
+	__attribute__((target("avx2"))) static int avx2_max(const int *a, int n)
+	{
+		__m256i m;
+		__m128i h;
+		int i = 8, result;
+
+		if (n < 8)
+			return sse_max(a, n);
+		m = _mm256_loadu_si256((const __m256i *)a);
+		for (; i + 8 <= n; i += 8)
+			m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i *)(a + i)));
+		h = _mm_max_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+		h = _mm_max_epi32(h, _mm_shuffle_epi32(h, 0x4E));
+		h = _mm_max_epi32(h, _mm_shuffle_epi32(h, 0xB1));
+		result = _mm_cvtsi128_si32(h);
+		for (; i < n; i++)
+			result = a[i] > result ? a[i] : result;
+		return result;
+	}
+	__attribute__((target("avx2"))) static void avx2_fill(int *a, int value, int n)
+	{
+		__m256i v = _mm256_set1_epi32(value);
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_si256((__m256i *)(a + i), v);
+		scalar_fill(a + i, value, n - i);
+	}
+	/// Сдвиги AVX2 работают в половинах по 128 бит: сумму нижней половины
+	/// переносим в верхнюю отдельно
+	__attribute__((target("avx2"))) static int avx2_prefix(int *a, int n)
+	{
+		__m256i carry = _mm256_setzero_si256(), x;
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+		{
+			x = _mm256_loadu_si256((const __m256i *)(a + i));
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+			x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+			x = _mm256_add_epi32(x, _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08), 0xFF));
+			x = _mm256_add_epi32(x, carry);
+			_mm256_storeu_si256((__m256i *)(a + i), x);
+			carry = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+		}
+		if (i < n)
+			a[i] = (int)((uint32_t)a[i] + (uint32_t)_mm256_cvtsi256_si32(carry));
+		else if (i)
+			return _mm256_cvtsi256_si32(carry);
+		return i < n ? scalar_prefix(a + i, n - i) : 0;
+	}
+	__attribute__((target("avx2"))) static int avx2_count_less(const int *a, int n, int value)
+	{
+		__m256i v = _mm256_set1_epi32(value), count = _mm256_setzero_si256();
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+			count = _mm256_sub_epi32(count, _mm256_cmpgt_epi32(v, _mm256_loadu_si256((const __m256i *)(a + i))));
+		return horizontal_sum(fold(count)) + scalar_count_less(a + i, n - i, value);
+	}
+	__attribute__((target("avx2"))) static int avx2_count_greater(const int *a, int n, int value)
+	{
+		__m256i v = _mm256_set1_epi32(value), count = _mm256_setzero_si256();
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+			count = _mm256_sub_epi32(count, _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(a + i)), v));
+		return horizontal_sum(fold(count)) + scalar_count_greater(a + i, n - i, value);
+	}
+	__attribute__((target("avx2"))) static int avx2_count_equal(const int *a, int n, int value)
+	{
+		__m256i v = _mm256_set1_epi32(value), count = _mm256_setzero_si256();
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+			count = _mm256_sub_epi32(count, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(a + i)), v));
+		return horizontal_sum(fold(count)) + scalar_count_equal(a + i, n - i, value);
+	}
+	__attribute__((target("avx2"))) static void avx2_add(int *to, const int *a, const int *b, int n)
+	{
+		int i = 0;
+
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_si256((__m256i *)(to + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(a + i)),
+																	   _mm256_loadu_si256((const __m256i *)(b + i))));
+		scalar_add(to + i, a + i, b + i, n - i);
+	}
+#endif
+
+	static array_kernels choose()
+	{
+#ifdef LITTLEC_X86_KERNELS
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return {"avx2", avx2_sum, avx2_dot, avx2_min, avx2_max, avx2_fill, move, avx2_prefix,
+					avx2_count_less, avx2_count_greater, avx2_count_equal, avx2_add};
+		if (__builtin_cpu_supports("sse4.1"))
+			return {"sse4.1", sse_sum, sse_dot, sse_min, sse_max, sse_fill, move, sse_prefix,
+					sse_count_less, sse_count_greater, sse_count_equal, sse_add};
+#endif
+		return {"scalar", scalar_sum, scalar_dot, scalar_min, scalar_max, scalar_fill, move, scalar_prefix,
+				scalar_count_less, scalar_count_greater, scalar_count_equal, scalar_add};
+	}
+};
+
+} // namespace littlec
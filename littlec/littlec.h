@@ -0,0 +1,7395 @@
+/**
+ * Интерпретатор Little C. Весь класс LittleC описан здесь, поэтому его можно
+ * встроить в свою программу, подключив littlec_lib:
+ *
+ *	auto program = LittleC("").compile_source("int twice(int a) { return a * 2; }");
+ *	LittleC context(program);
+ *	context.print_errors = false;
+ *	int result = context.call("twice", {12});	// 24, ошибка - в context.last_error
+ *	int *counter = context.global("counter");	// nullptr, если такой переменной нет
+ *
+ * Вывод программы идет в output_to (по умолчанию stdout), можно подставить memory_sink.
+ */
+#pragma once
+
+#include <iostream>
+#include <cstdio>
+#include <utility>
+#include <csetjmp>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <climits>
+#include <algorithm>
+#include <unordered_map>
+#include <functional>
+#include <charconv>
+#include <sys/resource.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include "enum.h"
+#include "kernels.h"
+
+/**
+ * Все, кроме LittleC и Scheduler, остается в пространстве имен littlec и не
+ * попадает в программу, которая подключает этот заголовок
+ */
+namespace littlec
+{
+
+/// TODO параша, на помойку это
+inline char *strcpy_s(char *dest, size_t count, const char *source)
+{
+	return strncpy(dest, source, count);
+}
+
+constexpr int ID_LEN = 32;
+constexpr int NUM_GLOBAL_VARS = 100;
+constexpr int NUMBER_FUNCTIONS = 100;
+constexpr int NUM_PARAMS = 31;
+constexpr int OUTPUT_BUFFER_SIZE = 65536;
+constexpr int INPUT_BUFFER_SIZE = 65536;
+
+class Scheduler;
+
+class LittleC
+{
+public:
+	/// TODO перевести
+	char *source_code_location;				/* current location in source code */
+	char *program_start_buffer;				/* points to start of program buffer */
+	jmp_buf execution_buffer;				/* hold environment for longjmp() */
+
+	char current_token[80];					/* string representation of current_token */
+	char token_type;						/* contains type of current_token */
+	char current_tok_datatype;				/* internal representation of current_token */
+
+	int global_variable_position;			/* индекс глобальной переменной в таблице global_vars */
+	int function_position;					/* index into function table_with_statements */
+
+	int function_last_index_on_call_stack;	/* index to top of function call stack */
+	int lvartos;						  	/* index into local variable stack */
+
+	int ret_value;		 					/* function return value */
+	long long wide_result;					/* то же без обрезки до int, для функций long */
+	int ret_occurring;	 					/* function return is occurring */
+	int break_occurring; 					/* loop break is occurring */
+
+	std::string fileName;						/* Название файла с программой */
+
+	/// TODO надо что-то с чтением без пути (не путю) сделать
+	std::string path = "/home/ahehiohyou/Desktop/works/zen/littlec/";
+
+	/// Заголовок кадра вызова. Слоты кадра - local_var_stack[base] и дальше до base следующего кадра
+	struct call_frame
+	{
+		int base;				/* первый слот кадра в local_var_stack */
+		char *return_location;	/* куда вернуться в коде после вызова */
+		int arrays;				/* первый массив кадра в frame_arrays */
+		int generators;			/* первый генератор кадра в frame_generators */
+		bool returns_string;	/* функция string: return копирует строку для вызывающего */
+	};
+	/// Стек вызовов растет удвоением и не сжимается, память кадров переиспользуется
+	std::vector<call_frame> call_stack;
+
+	/**
+	 * Массив int a[N] или char s[N]: элементы подряд в памяти, выровненной на
+	 * 64 байта. Переменная массива хранит описатель - индекс в arrays.
+	 * Строка (STR) - такой же массив символов с нулем в конце; короткая
+	 * лежит прямо в small, без второго выделения памяти.
+	 * get() и set() читают и пишут элемент одной атомарной операцией (relaxed):
+	 * массив могут одновременно менять задачи spawn() и parfor
+	 */
+	struct array_data
+	{
+		static constexpr int SMALL_STRING = 22;
+
+		int type;		/* INT, CHAR, LONG или STR */
+		bool variable = false; /* ячейка переменной long, а не массив: задача получает копию */
+		int length;		/* у строки - длина без нуля в конце */
+		int capacity;	/* у строки - сколько символов влезет без нового выделения */
+		int *ints;		/* элементы, если type == INT */
+		char *bytes;	/* элементы, если type == CHAR или STR */
+		long long *longs; /* элементы, если type == LONG */
+		char small[SMALL_STRING + 1];
+
+		array_data(int element_type, int count) : type(element_type), length(count), capacity(count)
+		{
+			size_t size = ((size_t)count * element_size() + (type == STR) + 63) & ~(size_t)63;
+			void *memory = small;
+
+			if (type != STR || count > SMALL_STRING)
+			{
+				memory = aligned_alloc(64, size);
+				if (!memory)
+					throw std::bad_alloc();
+			}
+			else
+				size = sizeof(small);
+			memset(memory, 0, size);
+			if (type == STR)
+				capacity = (int)size - 1;
+			ints = (int *)memory;
+			bytes = (char *)memory;
+			longs = (long long *)memory;
+		}
+		~array_data()
+		{
+			if (bytes != small)
+				free(ints);
+		}
+		array_data(const array_data &) = delete;
+		array_data &operator=(const array_data &) = delete;
+
+		size_t element_size() const
+		{
+			return type == CHAR || type == STR ? 1 : type == LONG ? sizeof(long long) : sizeof(int);
+		}
+		/**
+		 * Место под count символов строки, текст сохраняется. Растет удвоением,
+		 * поэтому дописывание в конец по символу - амортизированно O(1)
+		 */
+		void reserve(int count)
+		{
+			size_t size;
+			char *memory;
+
+			if (count <= capacity)
+				return;
+			size = ((size_t)std::max(count, 2 * capacity) + 1 + 63) & ~(size_t)63;
+			memory = (char *)aligned_alloc(64, size);
+			if (!memory)
+				throw std::bad_alloc();
+			memcpy(memory, bytes, length + 1);
+			if (bytes != small)
+				free(bytes);
+			ints = (int *)memory;
+			bytes = memory;
+			longs = (long long *)memory;
+			capacity = (int)size - 1;
+		}
+		/**
+		 * Заменить текст строки. text может быть частью ее же текста
+		 */
+		void assign(const char *text, int count)
+		{
+			reserve(count); /* свой текст не длиннее capacity, поэтому тут не переезжает */
+			memmove(bytes, text, count);
+			bytes[count] = '\0';
+			length = count;
+		}
+		/**
+		 * Дописать в конец. text может быть частью ее же текста
+		 */
+		void append(const char *text, int count)
+		{
+			uintptr_t offset = (uintptr_t)text - (uintptr_t)bytes;
+			bool own = offset <= (uintptr_t)length; /* s = concat(s, s) */
+
+			reserve(length + count);
+			if (own)
+				text = bytes + offset;
+			memmove(bytes + length, text, count);
+			length += count;
+			bytes[length] = '\0';
+		}
+		int get(int index) const
+		{
+			if (type == CHAR || type == STR)
+				return __atomic_load_n(&bytes[index], __ATOMIC_RELAXED);
+			if (type == LONG)
+				return (int)__atomic_load_n(&longs[index], __ATOMIC_RELAXED);
+			return __atomic_load_n(&ints[index], __ATOMIC_RELAXED);
+		}
+		void set(int index, int value)
+		{
+			if (type == CHAR || type == STR)
+				__atomic_store_n(&bytes[index], (char)value, __ATOMIC_RELAXED);
+			else if (type == LONG)
+				__atomic_store_n(&longs[index], (long long)value, __ATOMIC_RELAXED);
+			else
+				__atomic_store_n(&ints[index], value, __ATOMIC_RELAXED);
+		}
+		long long get_wide(int index) const
+		{
+			return type == LONG ? __atomic_load_n(&longs[index], __ATOMIC_RELAXED) : get(index);
+		}
+		void set_wide(int index, long long value)
+		{
+			if (type == LONG)
+				__atomic_store_n(&longs[index], value, __ATOMIC_RELAXED);
+			else
+				set(index, (int)value);
+		}
+	};
+	/// Массивы запуска по описателю; 0 - не массив. Задачи spawn() и parfor получают
+	/// копию таблицы, поэтому видят те же элементы массивов. Ячейки переменных long
+	/// и string у задачи свои - это значения, как int
+	std::vector<std::shared_ptr<array_data>> arrays;
+	std::vector<int> free_arrays;
+	/// Сколько задач сейчас делят массивы с этим контекстом; пока не 0, встроенные
+	/// функции и циклы над массивами идут через атомарные array_kernels::shared()
+	int sharing_tasks = 0;
+	/// Локальный массив и объявление, которое его создало
+	struct owned_array
+	{
+		int handle;
+		char *declared_at;
+	};
+	/// Массивы кадров вызова подряд; кадр владеет ими с call_frame::arrays
+	std::vector<owned_array> frame_arrays;
+	/// Строка-значение (результат concat(), литерал) и глубина вызовов, где она
+	/// появилась. Живет до начала следующей инструкции на этой глубине
+	struct temp_string
+	{
+		int handle;
+		int depth;
+	};
+	std::vector<temp_string> temp_strings;
+	/// В программе есть функции string - return проверяет call_frame::returns_string
+	bool string_functions = false;
+	/// Число элементов глобального массива, 0 - обычная переменная
+	int global_lengths[NUM_GLOBAL_VARS];
+	/// Массивы глобальных переменных созданы для этого запуска
+	bool globals_ready = false;
+	/// Самый большой массив, который можно объявить
+	int max_array_size = 1 << 26;
+
+	/// Предельная глубина вызовов; при превышении выполнение прерывается с NESTED_FUNCTIONS
+	int max_call_depth = 100000;
+	/// Предельное число локальных переменных во всех кадрах; при превышении - TOO_MANY_LVARS
+	int max_local_vars = 1 << 22;
+	/// Начало native-стека при запуске и сколько байт рекурсия интерпретатора может занять
+	char *native_stack_base = nullptr;
+	long native_stack_limit = 0;
+	/// Шагов (итераций циклов и вызовов функций) на один вызов входной функции
+	/// или на один отрезок между resume(); 0 - без ограничения
+	long step_budget = 0;
+	/// Когда шаги кончились: false - прервать с STEPS_EXHAUSTED, true - приостановить до resume()
+	bool suspend_on_budget = false;
+	/// Сколько шагов осталось; уходит в минус - пора в step_budget_exhausted()
+	long steps_left = LONG_MAX;
+	/// Приостанавливаемый запуск идет на отдельном стеке такого размера
+	size_t fiber_stack_size = 8 << 20;
+	context_state state = CONTEXT_IDLE;
+	/// В CONTEXT_WAITING - дескриптор, из которого программа хочет читать
+	int wait_fd = -1;
+	/// В CONTEXT_JOINING - задача планировщика, которую ждет join()
+	int join_task = -1;
+	/// Пул для spawn() и parfor. Если его нет, первый spawn() создает свой
+	/// (owned_pool) на pool_threads потоков, 0 - по числу ядер
+	Scheduler *pool = nullptr;
+	std::shared_ptr<Scheduler> owned_pool;
+	unsigned pool_threads = 0;
+	/// Контекст выполняется планировщиком pool и может уступать ему поток в join()
+	bool in_scheduler = false;
+	/// Задачи, запущенные spawn(): описатель в программе - индекс здесь
+	std::vector<int> started_tasks;
+	/// Номер этого контекста в планировщике pool
+	int task_id = -1;
+
+	/**
+	 * Канал chan(n): ограниченный кольцевой буфер Вьюкова. Отправители и
+	 * получатели не берут блокировок; lock нужен только тем, кто ждет
+	 */
+	struct channel
+	{
+		struct cell
+		{
+			std::atomic<size_t> sequence;
+			int value;
+		};
+
+		/// @param size емкость, степень двойки
+		explicit channel(size_t size) : mask(size - 1), cells(std::make_unique<cell[]>(size))
+		{
+			for (size_t i = 0; i < size; i++)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		bool try_send(int value)
+		{
+			size_t position = send_position.load(std::memory_order_relaxed);
+
+			for (;;)
+			{
+				cell &target = cells[position & mask];
+				intptr_t lag = (intptr_t)target.sequence.load(std::memory_order_acquire) - (intptr_t)position;
+
+				if (lag < 0)
+					return false; /* полон */
+				if (lag > 0)
+					position = send_position.load(std::memory_order_relaxed);
+				else if (send_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					target.value = value;
+					target.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+		}
+		bool try_recv(int &value)
+		{
+			size_t position = recv_position.load(std::memory_order_relaxed);
+
+			for (;;)
+			{
+				cell &source = cells[position & mask];
+				intptr_t lag = (intptr_t)source.sequence.load(std::memory_order_acquire) - (intptr_t)(position + 1);
+
+				if (lag < 0)
+					return false; /* пуст */
+				if (lag > 0)
+					position = recv_position.load(std::memory_order_relaxed);
+				else if (recv_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					value = source.value;
+					source.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+		}
+		bool can_send()
+		{
+			size_t position = send_position.load();
+
+			return cells[position & mask].sequence.load() == position;
+		}
+		bool can_recv()
+		{
+			size_t position = recv_position.load();
+
+			return cells[position & mask].sequence.load() == position + 1;
+		}
+		/**
+		 * Поставить контекст планировщика в очередь ждущих, если канал все еще
+		 * не готов. Счетчик waiting поднимается до повторной проверки, а
+		 * send()/recv() смотрят его после своей операции - кто-то из двух
+		 * обязательно увидит другого
+		 * @return false - канал уже готов, ждать не надо
+		 */
+		bool park(LittleC *context, bool sending)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			auto &queue = sending ? senders : receivers;
+
+			queue.push_back(context);
+			waiting++;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sending ? can_send() : can_recv())
+			{
+				queue.pop_back();
+				waiting--;
+				return false;
+			}
+			return true;
+		}
+
+		size_t mask;
+		std::unique_ptr<cell[]> cells;
+		alignas(64) std::atomic<size_t> send_position{0};
+		alignas(64) std::atomic<size_t> recv_position{0};
+
+		alignas(64) std::mutex lock;
+		std::deque<LittleC *> senders;		/* контексты планировщика, ждущие места */
+		std::deque<LittleC *> receivers;		/* и ждущие значения */
+		std::atomic<int> waiting{0};			/* все ждущие, включая потоки вне планировщика */
+		std::condition_variable changed;		/* для ждущих вне планировщика */
+	};
+	/// Каналы программы и ее задач: описатель в программе - индекс здесь
+	struct channel_table
+	{
+		std::mutex lock;
+		std::vector<std::unique_ptr<channel>> channels;
+	};
+	std::shared_ptr<channel_table> channels;
+	/// Уже найденные каналы, чтобы не брать channels->lock
+	std::vector<channel *> channel_cache;
+	/// В CONTEXT_BLOCKED - канал и что с ним хотят сделать
+	channel *blocked_on = nullptr;
+	bool blocked_sending = false;
+	/// Последняя ошибка выполнения (из error_msg) или -1
+	int last_error = -1;
+	/// Печатать ошибки в cout; хост, встроивший интерпретатор, может их выключить и смотреть last_error
+	bool print_errors = true;
+	/// Длина текста программы, столько же элементов в кешах по смещению
+	long program_size = 0;
+
+	/// TODO что это ебать
+	struct commands
+	{ /* keyword lookup table_with_statements */
+		char command[20];
+		char tok;
+	} table_with_statements[16] = {
+			/* Commands must be entered lowercase */
+			{"if", IF}, /* in this table_with_statements. */
+			{"else", ELSE},
+			{"for", FOR},
+			{"do", DO},
+			{"while", WHILE},
+			{"char", CHAR},
+			{"int", INT},
+			{"long", LONG},
+			{"string", STR},
+			{"return", RETURN},
+			{"continue", CONTINUE},
+			{"break", BREAK},
+			{"end", END},
+			{"parfor", PARFOR},
+			{"yield", YIELD},
+			{"", END} /* mark end of table_with_statements */
+	};
+
+	/**
+	 * Память для всего, что строится при загрузке и компиляции: буфер программы,
+	 * деревья выражений, записи кешей. Выделение - сдвиг указателя в текущем блоке,
+	 * освободить все сразу - reset(). Блоки не возвращаются системе, а
+	 * переиспользуются следующим запуском, поэтому память не фрагментируется.
+	 * Объекты в арене не разрушаются - класть сюда можно только тривиальные типы.
+	 */
+	class arena
+	{
+	public:
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+		/**
+		 * Выделить size байт с выравниванием align
+		 */
+		void *allocate(size_t size, size_t align = alignof(max_align_t))
+		{
+			size_t offset = (used + align - 1) & ~(align - 1);
+
+			while (current >= blocks.size() || offset + size > blocks[current].size)
+			{
+				if (current < blocks.size())
+					current++;
+				if (current == blocks.size())
+					blocks.push_back({std::make_unique<char[]>(std::max(size, BLOCK_SIZE)), std::max(size, BLOCK_SIZE)});
+				offset = 0;
+			}
+			used = offset + size;
+			return blocks[current].memory.get() + offset;
+		}
+		/**
+		 * Создать объект в арене
+		 */
+		template <typename T, typename... Args>
+		T *make(Args &&...args)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "арена не вызывает деструкторы");
+			return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+		}
+		/**
+		 * Забыть все выделенное, блоки остаются для следующих выделений
+		 */
+		void reset()
+		{
+			current = 0;
+			used = 0;
+		}
+		/**
+		 * Сколько байт занимают блоки арены
+		 */
+		size_t capacity() const
+		{
+			size_t total = 0;
+
+			for (auto &block : blocks)
+				total += block.size;
+			return total;
+		}
+
+	private:
+		struct block
+		{
+			std::unique_ptr<char[]> memory;
+			size_t size;
+		};
+		std::vector<block> blocks;
+		size_t current = 0;	/* блок, из которого сейчас выделяем */
+		size_t used = 0;	/* занято байт в текущем блоке */
+	};
+
+	/**
+	 * Куда уходит вывод программы. LittleC копит вывод в своем буфере и отдает
+	 * его сюда большими кусками: когда буфер заполнен, после run() и по flush_output()
+	 */
+	class output_sink
+	{
+	public:
+		virtual ~output_sink() = default;
+		/**
+		 * Записать count кусков подряд
+		 */
+		virtual void write(const iovec *pieces, int count) = 0;
+	};
+	/// Вывод в файловый дескриптор, все куски одним writev()
+	class fd_sink : public output_sink
+	{
+	public:
+		explicit fd_sink(int fd) : fd(fd) {}
+
+		void write(const iovec *pieces, int count) override
+		{
+			std::vector<iovec> rest(pieces, pieces + count);
+			size_t first = 0;
+			ssize_t written;
+
+			while (first < rest.size())
+			{
+				written = writev(fd, rest.data() + first, (int)(rest.size() - first));
+				if (written < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					return; /* выводить некуда - вывод теряется, как у printf */
+				}
+				/* writev мог записать не все - пропускаем записанное */
+				for (; first < rest.size() && (size_t)written >= rest[first].iov_len; first++)
+					written -= (ssize_t)rest[first].iov_len;
+				if (first < rest.size())
+				{
+					rest[first].iov_base = (char *)rest[first].iov_base + written;
+					rest[first].iov_len -= written;
+				}
+			}
+		}
+
+	private:
+		int fd;
+	};
+	/// Вывод в строку, например чтобы проверить, что напечатала программа
+	class memory_sink : public output_sink
+	{
+	public:
+		void write(const iovec *pieces, int count) override
+		{
+			std::lock_guard<std::mutex> guard(lock); /* в один sink пишут и задачи spawn() */
+
+			for (int i = 0; i < count; i++)
+				data.append((const char *)pieces[i].iov_base, pieces[i].iov_len);
+		}
+
+		std::string data;
+		std::mutex lock;
+	};
+	/// Вывод в функцию хоста
+	class callback_sink : public output_sink
+	{
+	public:
+		explicit callback_sink(std::function<void(const char *, size_t)> callback) : callback(std::move(callback)) {}
+
+		void write(const iovec *pieces, int count) override
+		{
+			for (int i = 0; i < count; i++)
+				callback((const char *)pieces[i].iov_base, pieces[i].iov_len);
+		}
+
+	private:
+		std::function<void(const char *, size_t)> callback;
+	};
+
+	/**
+	 * Ввод программы большими кусками из файлового дескриптора. Через него
+	 * читают getnum(), getche() и --each-line, так что ни один байт не теряется
+	 * между ними.
+	 */
+	class input_reader
+	{
+	public:
+		explicit input_reader(int fd) : fd(fd), buffer(std::make_unique<char[]>(INPUT_BUFFER_SIZE)) {}
+
+		/// Вызывается перед read(); возвращается, когда в fd есть что читать (или конец ввода)
+		std::function<void(int fd)> wait_readable;
+
+		/**
+		 * Следующее целое число; числа разделяются любыми пробелами и переводами строк
+		 * @param value сюда число, 0 если его нет
+		 * @return INPUT_OK, INPUT_EOF или INPUT_NOT_NUMBER (слово пропущено)
+		 */
+		int read_number(int &value)
+		{
+			size_t word_end;
+			const char *first;
+
+			value = 0;
+			for (;;)
+			{ /* пропускаем пробелы */
+				while (begin < end && isspace((unsigned char)buffer[begin]))
+					begin++;
+				if (begin < end)
+					break;
+				if (!fill())
+					return INPUT_EOF;
+			}
+			for (;;)
+			{ /* слово целиком должно быть в буфере */
+				word_end = begin;
+				while (word_end < end && !isspace((unsigned char)buffer[word_end]))
+					word_end++;
+				if (word_end < end || finished || end - begin == INPUT_BUFFER_SIZE)
+					break;
+				fill();
+			}
+			first = buffer.get() + begin;
+			if (*first == '+' && word_end - begin > 1)
+				first++;
+			auto [last, error] = std::from_chars(first, buffer.get() + word_end, value);
+			begin = word_end;
+			if (error != std::errc() || last != buffer.get() + word_end)
+			{
+				value = 0;
+				return INPUT_NOT_NUMBER;
+			}
+			return INPUT_OK;
+		}
+		/**
+		 * Следующий символ или -1, если ввод кончился
+		 */
+		int read_char()
+		{
+			if (begin == end && !fill())
+				return -1;
+			return (unsigned char)buffer[begin++];
+		}
+		/**
+		 * Строка без перевода строки
+		 * @return false, если ввод кончился
+		 */
+		bool read_line(std::string &line)
+		{
+			const char *newline;
+
+			line.clear();
+			for (;;)
+			{
+				newline = (const char *)memchr(buffer.get() + begin, '\n', end - begin);
+				if (newline)
+				{
+					line.append(buffer.get() + begin, newline - (buffer.get() + begin));
+					begin = newline - buffer.get() + 1;
+					return true;
+				}
+				line.append(buffer.get() + begin, end - begin);
+				begin = end;
+				if (!fill())
+					return !line.empty();
+			}
+		}
+
+	private:
+		/**
+		 * Сдвинуть непрочитанное в начало буфера и дочитать
+		 * @return false, если новых байт нет
+		 */
+		bool fill()
+		{
+			ssize_t count;
+
+			if (finished)
+				return false;
+			memmove(buffer.get(), buffer.get() + begin, end - begin);
+			end -= begin;
+			begin = 0;
+			if (wait_readable)
+				wait_readable(fd);
+			do
+				count = ::read(fd, buffer.get() + end, INPUT_BUFFER_SIZE - end);
+			while (count < 0 && errno == EINTR);
+			if (count <= 0)
+			{
+				finished = true;
+				return false;
+			}
+			end += count;
+			return true;
+		}
+
+		int fd;
+		std::unique_ptr<char[]> buffer;
+		size_t begin = 0;		/* первый непрочитанный байт */
+		size_t end = 0;			/* конец прочитанного в буфер */
+		bool finished = false;	/* read() вернул конец ввода */
+	};
+
+	/// Узел скомпилированного дерева выражения
+	struct expr_node
+	{
+		char op;				/* операция из expr_ops */
+		int value;				/* значение константы; у вызова - 1, если функция - генератор */
+		char name[ID_LEN];		/* имя переменной или функции */
+		int name_id;			/* номер имени переменной из variable_id() */
+		char *source;			/* место в исходном коде, откуда узел взят */
+		char *loc;				/* точка входа вызываемой функции */
+		int magic;				/* магическое число для деления на константу */
+		int shift;				/* сдвиг после умножения на магическое число */
+		char relop;				/* оператор сравнения у слитых сравнений (LOWER...NOT_EQUAL), операция OP_CHECKED */
+		bool wide;				/* значение 64-битное (long) */
+		long long number;		/* значение 64-битной константы */
+		expr_node *left;		/* левый операнд; у вызова - первый аргумент */
+		expr_node *right;		/* правый операнд */
+		expr_node *other;		/* ветка else у OP_SELECT */
+		expr_node *next;		/* следующий аргумент вызова */
+	};
+
+	/// Локальная переменная, которой в функции один раз присваивается константа
+	struct constant_local
+	{
+		char variable_name[ID_LEN];
+		int value;
+		char *valid_from; /* после этого места в коде переменная равна value */
+	};
+
+	/// Массив, длина которого в этом месте функции известна без выполнения
+	struct array_bound
+	{
+		int name_id;
+		int length;
+		char *valid_from; /* после этого места в коде имя означает этот массив */
+	};
+
+	/// Хранит тип возвращаемых данных, название функции, местоположение в коде
+	struct function_type
+	{
+		char func_name[ID_LEN];
+		int ret_type;
+		char *loc; /* location of entry point in file */
+		char *end; /* закрывающая } тела функции */
+		int analyzed; /* 0 - не анализировали, 1 - анализ идет, 2 - готово */
+		std::vector<constant_local> constants;
+		std::vector<array_bound> arrays; /* из analyze_function_constants() */
+		std::vector<int> long_names;		/* переменные long */
+		std::vector<int> long_arrays;	/* массивы long */
+		std::vector<int> unsure_names;	/* в разных местах long и не long - тип смотрится при выполнении */
+		std::vector<int> string_names;	/* переменные string: присваивание копирует текст */
+		std::vector<int> mixed_string_names; /* string только в части функции - присваивание разбирает assign_var() */
+		int inline_state; /* 0 - не разбирали, 1 - разбор идет, 2 - готово */
+		expr_node *inline_body; /* тело для подстановки в место вызова или nullptr */
+		std::vector<std::string> params;
+		bool generator; /* в теле есть yield: вызов возвращает описатель для next() */
+	} function_table[NUMBER_FUNCTIONS];
+
+	/**
+	 * Загруженная программа: текст, функции и глобальные переменные, найденные
+	 * prescan_source_code(). После compile() не меняется, поэтому один объект могут
+	 * одновременно выполнять несколько LittleC из разных потоков без блокировок.
+	 * Все, что копится при выполнении (деревья выражений, анализ функций), у
+	 * каждого LittleC свое.
+	 */
+	struct compiled_program
+	{
+		arena memory;						/* тут лежит текст программы */
+		char *text = nullptr;
+		size_t size = 0;					/* длина text вместе с нулями в конце */
+		char *main_location = nullptr;		/* открывающая ( у main или nullptr */
+		std::vector<function_type> functions;	/* только имя, тип, начало и конец */
+		struct global_variable
+		{
+			std::string name;
+			int variable_type;
+			int length;						/* у массива - число элементов, иначе 0 */
+		};
+		std::vector<global_variable> globals;
+	};
+	/// Программа, которую выполняет этот LittleC
+	std::shared_ptr<const compiled_program> program;
+
+	/// Выражение, скомпилированное один раз и закешированное по месту в коде
+	struct compiled_expression
+	{
+		expr_node *root;		/* nullptr - выражение не удалось скомпилировать */
+		expr_node *code;		/* root после слияния в суперинструкции, его и выполняем */
+		char *end;				/* source_code_location после вычисления */
+		char terminator[ID_LEN];	/* токен, на котором выражение закончилось */
+		char terminator_type;
+		char terminator_datatype;
+	};
+
+	/// Буфер программы, деревья выражений и кеши; живут до следующего execute()
+	arena memory;
+
+	/// Печатать выражения до и после оптимизации
+	bool dump_optimizations = false;
+	/// Скомпилированные выражения, индекс - смещение от program_start_buffer
+	std::vector<compiled_expression *> expression_cache;
+	/// Концы блоков, найденные find_eob(), индекс - смещение начала поиска
+	std::vector<char *> block_end_cache;
+
+	/// Разобранный заголовок цикла for
+	/// Цикл for (i = ...; i < bound; i = i + 1) { одна инструкция }, который
+	/// выполняется ядром из kernels.h
+	struct loop_kernel
+	{
+		int kind;			/* из loop_kernels */
+		expr_node *counter;	/* переменная цикла i */
+		expr_node *bound;	/* OP_CONST или переменная, которую тело не меняет */
+		bool inclusive;		/* i <= bound */
+		expr_node *target;	/* сумма или счетчик, для KERNEL_ADD - массив результата */
+		expr_node *first;	/* массивы в теле */
+		expr_node *second;
+		int compare;		/* KERNEL_COUNT: a[i] compare limit */
+		expr_node *limit;
+		char *end;			/* за } тела */
+	};
+	struct compiled_for
+	{
+		char *body;					/* начало тела цикла после ) */
+		expr_node *step_and_test;	/* слитые шаг и условие или nullptr */
+		loop_kernel *kernel;		/* весь цикл одним вызовом или nullptr */
+	};
+	/// Циклы for, индекс - смещение выражения шага
+	std::vector<compiled_for *> for_cache;
+	/// Переменная цикла for, которая в теле цикла (from, to) не выходит из [low, high]
+	struct index_range
+	{
+		int name_id;
+		int low;
+		int high;
+		char *from;
+		char *to;
+	};
+	std::vector<index_range> index_ranges;
+
+	/// Считать пары операций родитель-потомок при выполнении (--op-stats)
+	bool op_stats = false;
+	std::vector<long long> op_counts;
+	std::vector<long long> op_pair_counts;
+	/// Функция, выражение которой сейчас оптимизируется
+	int optimizing_function = -1;
+	/// Сколько узлов может быть в теле функции, которую подставляем в место вызова. 0 - не подставлять
+	int inline_budget = 16;
+	/// Сложение, вычитание, умножение и минус проверяют переполнение (--checked)
+	bool checked_arithmetic = false;
+
+	/// Сюда пишет find_var_slot(), если переменной нет
+	int missing_variable = 0;
+
+	/// Хвостовой вызов, который ждет, пока текущая функция освободит свой кадр
+	expr_node *tail_call = nullptr;
+	int tail_call_args[NUM_PARAMS];
+	int tail_call_count = 0;
+
+	/// Имя и тип переменной. Нужны только при поиске по имени, поэтому лежат
+	/// отдельно от значений: при выполнении читается плотный массив int
+	struct variable_type
+	{
+		int name_id; /* номер в variable_names */
+		int variable_type;
+	} global_vars[NUM_GLOBAL_VARS];
+	/// Имена переменных по номеру; сравнивать при поиске приходится только номера
+	std::vector<std::string> variable_names;
+	std::unordered_map<std::string, int> variable_ids;
+	/// Значения глобальных переменных, global_values[i] принадлежит global_vars[i]
+	alignas(64) int global_values[NUM_GLOBAL_VARS];
+
+	/// Имена локальных переменных всех кадров подряд, растет так же, как call_stack
+	std::vector<variable_type> local_var_stack;
+	/// Значения локальных переменных, local_values[i] принадлежит local_var_stack[i]
+	std::vector<int> local_values;
+
+	/// Конструктор
+	/// мейэби анюзд..........	 пХАХАХПАХПХХАХАХ В ГОЛОС
+	[[maybe_unused]] explicit LittleC(std::string _fileName) : fileName(std::move(_fileName))
+	{
+		register_builtins();
+	}
+	/// Выполнять уже загруженную программу, не читая файл заново
+	explicit LittleC(std::shared_ptr<const compiled_program> compiled)
+	{
+		register_builtins();
+		attach(std::move(compiled));
+	}
+	~LittleC()
+	{
+		flush_output();
+	}
+
+	/**
+	 * Загрузить программу из файла (если еще не загружена) и выполнить main
+	 * @return 0 - программа отработала, 1 - ошибка
+	 */
+	int execute()
+	{
+		if (!program && !compile())
+			return 1;
+		return run();
+	}
+	/**
+	 * Прочитать файл, найти функции и глобальные переменные и запомнить их в
+	 * неизменяемом compiled_program, который можно отдать другим LittleC.
+	 * Этот LittleC после вызова выполняет полученную программу.
+	 * @return nullptr, если программу загрузить не удалось
+	 */
+	std::shared_ptr<const compiled_program> compile()
+	{
+		std::string source;
+
+		/// Если названия файла нет - выход
+		if (fileName.empty())
+		{
+			report("Пустое имя файла");
+			return nullptr;
+		}
+
+		/// Загрузить программу для выполнения
+		if (!load_program(source, fileName))
+		{
+			report("Не удалось считать код");
+			return nullptr;
+		}
+		return compile_source(source);
+	}
+	/**
+	 * То же, что compile(), но текст программы уже в памяти
+	 * @param source
+	 * @return nullptr, если программу разобрать не удалось
+	 */
+	std::shared_ptr<const compiled_program> compile_source(const std::string &source)
+	{
+		auto compiled = std::make_shared<compiled_program>();
+
+		/// Текст с двумя нулями в конце: токенизатор заглядывает на символ вперед
+		compiled->size = source.size() + 2;
+		compiled->text = (char *)compiled->memory.allocate(compiled->size);
+		memcpy(compiled->text, source.data(), source.size());
+		compiled->text[source.size()] = compiled->text[source.size() + 1] = '\0';
+
+		/// Инициализация индекса глобальных переменных
+		global_variable_position = 0;
+		/// Установка указателя на начало буфера программы
+		program_start_buffer = source_code_location = compiled->text;
+
+		/// Определение адресов всех функций и глобальных переменных
+		prescan_source_code();
+
+		/// без main программу можно только вызывать через call()
+		compiled->main_location = find_function_in_function_table("main");
+
+		for (int i = 0; i < function_position; i++)
+		{
+			compiled->functions.emplace_back();
+			strcpy_s(compiled->functions.back().func_name, ID_LEN, function_table[i].func_name);
+			compiled->functions.back().ret_type = function_table[i].ret_type;
+			compiled->functions.back().loc = function_table[i].loc;
+			compiled->functions.back().end = function_table[i].end;
+			compiled->functions.back().generator = function_table[i].generator;
+		}
+		for (int i = 0; i < global_variable_position; i++)
+			compiled->globals.push_back({variable_names[global_vars[i].name_id], global_vars[i].variable_type,
+										 global_lengths[i]});
+
+		attach(compiled);
+		return compiled;
+	}
+	/**
+	 * Выполнять программу compiled. Все, что было скомпилировано для прошлой
+	 * программы, освобождается разом
+	 */
+	void attach(std::shared_ptr<const compiled_program> compiled)
+	{
+		program = std::move(compiled);
+		program_start_buffer = program->text;
+		program_size = (long)program->size;
+
+		function_position = (int)program->functions.size();
+		string_functions = false;
+		for (int i = 0; i < function_position; i++)
+		{
+			function_table[i] = program->functions[i];
+			string_functions |= function_table[i].ret_type == STR;
+			function_table[i].analyzed = 0;
+			function_table[i].constants.clear();
+			function_table[i].arrays.clear();
+			function_table[i].long_names.clear();
+			function_table[i].long_arrays.clear();
+			function_table[i].unsure_names.clear();
+			function_table[i].string_names.clear();
+			function_table[i].mixed_string_names.clear();
+			function_table[i].inline_state = 0;
+			function_table[i].inline_body = nullptr;
+			function_table[i].params.clear();
+		}
+		global_variable_position = (int)program->globals.size();
+		for (int i = 0; i < global_variable_position; i++)
+		{
+			global_vars[i].name_id = variable_id(program->globals[i].name.c_str());
+			global_vars[i].variable_type = program->globals[i].variable_type;
+			global_lengths[i] = program->globals[i].length;
+		}
+		std::fill(global_values, global_values + global_variable_position, 0);
+		globals_ready = false;
+
+		memory.reset();
+		index_ranges.clear();
+		/// Кеши скомпилированных выражений и концов блоков пусты
+		expression_cache.assign(program_size, nullptr);
+		block_end_cache.assign(program_size, nullptr);
+		for_cache.assign(program_size, nullptr);
+		op_counts.assign(OP_COUNT, 0);
+		op_pair_counts.assign(OP_COUNT * OP_COUNT, 0);
+	}
+	/**
+	 * Выполнить main с обнуленными глобальными переменными. Деревья выражений,
+	 * скомпилированные прошлыми запусками, остаются и используются снова
+	 * @return 0 - программа отработала (или приостановлена, см. state), 1 - ошибка
+	 */
+	int run()
+	{
+		return resumable([this] { return run_main(); });
+	}
+	int run_main()
+	{
+		/// main написан с ошибкой или отсутствует
+		if (!program->main_location)
+		{
+			report("\"main\" не найдено или написано с ошибкой");
+			return 1;
+		}
+		clear_globals();
+		/// Вызываем функцию main она всегда вызывается первой
+		if (call_entry(program->main_location, "main"))
+		{
+			flush_output();
+			return 1;
+		}
+		flush_output();
+
+		if (op_stats)
+			print_op_stats();
+		return 0;
+	}
+	/**
+	 * Режим --each-line: программа загружается один раз, а entry вызывается для
+	 * каждой строки stdin. Строку читают getnum() (следующее число) и field(n)
+	 * (n-е поле, field(0) - число полей). Глобальные переменные обнуляются только
+	 * перед первой строкой и копят значения между строками.
+	 * @param entry функция без параметров
+	 * @return 0 - все строки обработаны, 1 - ошибка
+	 */
+	int execute_each_line(const char *entry)
+	{
+		return resumable([this, name = std::string(entry)] { return each_line(name.c_str()); });
+	}
+	int each_line(const char *entry)
+	{
+		char *location;
+
+		if (!program && !compile())
+			return 1;
+		location = find_function_in_function_table((char *)entry);
+		if (!location)
+		{
+			report("\"" + std::string(entry) + "\" не найдено или написано с ошибкой");
+			return 1;
+		}
+
+		clear_globals();
+		record_mode = true;
+		while (input_from->read_line(current_record))
+		{
+			if (!current_record.empty() && current_record.back() == '\r')
+				current_record.pop_back();
+			record_position = 0;
+			if (call_entry(location, entry))
+			{
+				flush_output();
+				return 1;
+			}
+		}
+		record_mode = false;
+		flush_output();
+
+		if (op_stats)
+			print_op_stats();
+		return 0;
+	}
+	/**
+	 * Вызвать функцию без аргументов с пустыми стеками
+	 * @param location открывающая ( в заголовке функции
+	 * @param name
+	 * @return 0 - функция отработала, 1 - выполнение прервано ошибкой
+	 */
+	int call_entry(char *location, const char *name)
+	{
+		/// Сюда возвращает runtime_error(): выполнение прервано, но процесс живет дальше
+		switch (setjmp(execution_buffer))
+		{
+			case RUN_ABORTED:
+				return 1;
+			case RUN_ENDED:
+				return 0;
+		}
+		reset_stacks();
+		/// Функция с yield стала бы генератором: вызов вернул бы описатель, не выполнив ничего
+		if (is_generator(location))
+			runtime_error(YIELD_OUTSIDE);
+
+		/// Возвращаемся к открывающей (
+		source_code_location = location - 1;
+		strcpy_s(current_token, 80, name);
+		/// Вызываем функцию и интерпретируем
+		call_function();
+		return 0;
+	}
+
+	/**
+	 * Вызвать функцию программы из C++ и получить ее результат. Глобальные
+	 * переменные не обнуляются - их можно заранее записать через global()
+	 * @param name
+	 * @param args аргументы по порядку
+	 * @return результат функции; 0, если она дошла до end или была ошибка (last_error >= 0).
+	 * Генератор (функцию с yield) так вызвать нельзя - ошибка YIELD_OUTSIDE
+	 */
+	int call(const std::string &name, const std::vector<int> &args = {})
+	{
+		return resumable([this, name, args] { return call_by_name(name, args); });
+	}
+	int call_by_name(const std::string &name, const std::vector<int> &args)
+	{
+		char *location = find_function_in_function_table((char *)name.c_str());
+		int count;
+
+		last_error = -1;
+		if (!location)
+		{
+			syntax_error(FUNC_UNDEFINED);
+			return 0;
+		}
+		if (args.size() > NUM_PARAMS)
+		{
+			syntax_error(PARAM_ERR);
+			return 0;
+		}
+		switch (setjmp(execution_buffer))
+		{
+			case RUN_ABORTED:
+				flush_output();
+				return 0;
+			case RUN_ENDED: /* end - программа закончена без результата */
+				flush_output();
+				return 0;
+		}
+		reset_stacks();
+		if (is_generator(location))
+			runtime_error(YIELD_OUTSIDE);
+		if (!globals_ready)
+			make_global_arrays();
+
+		for (count = (int)args.size() - 1; count >= 0; count--)
+			local_push(nullptr, ARG, args[count]);
+		function_push_variables_on_call_stack(0, nullptr);
+		source_code_location = location;
+		interpret_function_body();
+		func_pop();
+		flush_output();
+		return ret_value;
+	}
+	/**
+	 * Где лежит значение глобальной переменной программы: его можно читать и
+	 * писать между вызовами run() и call()
+	 * @param name
+	 * @return nullptr, если такой глобальной переменной нет или она long
+	 */
+	int *global(const std::string &name)
+	{
+		int name_id = known_variable_id(name.c_str());
+
+		if (!globals_ready)
+			make_global_arrays();
+		for (int i = 0; i < global_variable_position; i++)
+			if (global_vars[i].name_id == name_id)
+				return !global_lengths[i] && (global_vars[i].variable_type == LONG || global_vars[i].variable_type == STR)
+						   ? nullptr : &global_values[i];
+		return nullptr;
+	}
+	/**
+	 * То же для глобальной переменной long
+	 */
+	long long *global_long(const std::string &name)
+	{
+		int name_id = known_variable_id(name.c_str());
+
+		if (!globals_ready)
+			make_global_arrays();
+		for (int i = 0; i < global_variable_position; i++)
+			if (global_vars[i].name_id == name_id && !global_lengths[i] && global_vars[i].variable_type == LONG)
+				return arrays[global_values[i]]->longs;
+		return nullptr;
+	}
+	/**
+	 * Текст глобальной переменной string, до следующего присваивания ей
+	 */
+	const char *global_string(const std::string &name)
+	{
+		int name_id = known_variable_id(name.c_str());
+
+		if (!globals_ready)
+			make_global_arrays();
+		for (int i = 0; i < global_variable_position; i++)
+			if (global_vars[i].name_id == name_id && !global_lengths[i] && global_vars[i].variable_type == STR)
+				return arrays[global_values[i]]->bytes;
+		return nullptr;
+	}
+	/**
+	 * Пустые стеки перед вызовом функции снаружи
+	 */
+	void reset_stacks()
+	{
+		last_error = -1;
+		set_native_stack_limit();
+
+		/// Инициализация индекса стека локальных переменных
+		lvartos = 0;
+		/// Инициализация индекса стека вызова CALL
+		function_last_index_on_call_stack = 0;
+		/// initialize the break occurring flag
+		break_occurring = 0;
+		ret_occurring = 0;
+		tail_call = nullptr;
+		release_temp_strings(0);
+		steps_left = step_budget ? step_budget : LONG_MAX;
+		generators.clear();
+		free_generators.clear();
+		frame_generators.clear();
+		current_generator = nullptr;
+		release_frame_arrays(0);
+	}
+	/**
+	 * Продолжить запуск, приостановленный из-за step_budget или ожидания ввода,
+	 * с новым запасом шагов
+	 * @return то же, что вернул бы приостановленный run(), call() или execute_each_line()
+	 */
+	int resume()
+	{
+		if (state == CONTEXT_IDLE || state == CONTEXT_RUNNING)
+			return 1;
+		steps_left = step_budget;
+		return switch_to_fiber();
+	}
+
+	/// Отдельный стек приостанавливаемого запуска и место, куда из него возвращаться
+	struct fiber
+	{
+		ucontext_t script{};
+		ucontext_t host{};
+		char *stack = nullptr;
+		size_t size = 0;
+		std::function<int()> body;
+		int result = 0;
+
+		explicit fiber(size_t stack_size) : size(stack_size)
+		{
+			void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+								MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+
+			if (memory == MAP_FAILED)
+				throw std::bad_alloc();
+			stack = (char *)memory;
+			mprotect(stack, 4096, PROT_NONE); /* переполнение - SIGSEGV, а не чужая память */
+		}
+		~fiber()
+		{
+			munmap(stack, size);
+		}
+		fiber(const fiber &) = delete;
+		fiber &operator=(const fiber &) = delete;
+	};
+	std::unique_ptr<fiber> running_fiber;
+
+	/**
+	 * Выполнить body как запуск программы. Если шаги могут кончиться с
+	 * приостановкой, body идет на отдельном стеке: тогда с него можно уйти
+	 * посреди выполнения и вернуться через resume()
+	 * @param body
+	 * @return результат body или 0, если запуск приостановлен
+	 */
+	int resumable(std::function<int()> body)
+	{
+		if (!suspend_on_budget || !step_budget)
+			return body();
+		/* приостановленный запуск надо сначала довести до конца */
+		if (state != CONTEXT_IDLE)
+			return 1;
+		if (!running_fiber)
+			running_fiber = std::make_unique<fiber>(fiber_stack_size);
+
+		running_fiber->body = std::move(body);
+		getcontext(&running_fiber->script);
+		running_fiber->script.uc_stack.ss_sp = running_fiber->stack;
+		running_fiber->script.uc_stack.ss_size = running_fiber->size;
+		running_fiber->script.uc_link = &running_fiber->host;
+		makecontext(&running_fiber->script, (void (*)())fiber_entry, 2,
+					(unsigned)((uintptr_t)this >> 32), (unsigned)(uintptr_t)this);
+		return switch_to_fiber();
+	}
+	/**
+	 * Начало стека приостанавливаемого запуска. makecontext передает только
+	 * int, поэтому this приходит двумя половинами
+	 */
+	static void fiber_entry(unsigned high, unsigned low)
+	{
+		auto self = (LittleC *)(((uintptr_t)high << 32) | low);
+
+		self->running_fiber->result = self->running_fiber->body();
+	}
+	/**
+	 * Перейти на стек запуска и ждать, пока он закончится или приостановится
+	 */
+	int switch_to_fiber()
+	{
+		state = CONTEXT_RUNNING;
+		swapcontext(&running_fiber->host, &running_fiber->script);
+		if (state != CONTEXT_RUNNING)
+			return 0;
+		state = CONTEXT_IDLE;
+		return running_fiber->result;
+	}
+	/**
+	 * Шаг программы: итерация цикла или вызов функции
+	 */
+	void count_step()
+	{
+		if (--steps_left < 0)
+			step_budget_exhausted();
+	}
+	/**
+	 * Шаги кончились: приостановить запуск или прервать его
+	 */
+	void step_budget_exhausted()
+	{
+		if (!step_budget)
+		{
+			steps_left = LONG_MAX;
+			return;
+		}
+		if (state != CONTEXT_RUNNING)
+			runtime_error(STEPS_EXHAUSTED);
+		flush_output();
+		state = CONTEXT_SUSPENDED;
+		swapcontext(&running_fiber->script, &running_fiber->host);
+	}
+	/**
+	 * Ввода в fd пока нет: приостановить запуск до его появления, чтобы не
+	 * занимать поток. Без отдельного стека просто ждем в read()
+	 * @param fd
+	 */
+	void wait_for_input(int fd)
+	{
+		struct pollfd input{fd, POLLIN, 0};
+
+		if (fd < 0 || state != CONTEXT_RUNNING || poll(&input, 1, 0) != 0)
+			return;
+		flush_output();
+		wait_fd = fd;
+		state = CONTEXT_WAITING;
+		swapcontext(&running_fiber->script, &running_fiber->host);
+		wait_fd = -1;
+	}
+
+	/// Место разбора, которое надо сохранить, уходя со стека генератора или на него
+	struct parse_state
+	{
+		char *location;
+		char token[80];
+		char token_type;
+		char datatype;
+		int ret_value;
+		int ret_occurring;
+		int break_occurring;
+	};
+	void save_parse_state(parse_state &saved)
+	{
+		saved.location = source_code_location;
+		memcpy(saved.token, current_token, sizeof(current_token));
+		saved.token_type = token_type;
+		saved.datatype = current_tok_datatype;
+		saved.ret_value = ret_value;
+		saved.ret_occurring = ret_occurring;
+		saved.break_occurring = break_occurring;
+	}
+	void restore_parse_state(const parse_state &saved)
+	{
+		source_code_location = saved.location;
+		memcpy(current_token, saved.token, sizeof(current_token));
+		token_type = saved.token_type;
+		current_tok_datatype = saved.datatype;
+		ret_value = saved.ret_value;
+		ret_occurring = saved.ret_occurring;
+		break_occurring = saved.break_occurring;
+	}
+	/**
+	 * Генератор - вызов функции с yield. Пока он стоит на yield, его кадр
+	 * (слоты local_var_stack и заголовки call_stack) лежит здесь, а next()
+	 * кладет кадр обратно на вершину стеков - туда, где next() вызвали.
+	 * Рекурсия интерпретатора внутри тела идет на собственном стеке stack
+	 */
+	struct generator
+	{
+		std::unique_ptr<fiber> stack;		/* выделяется первым next() */
+		jmp_buf errors;					/* сюда runtime_error() внутри тела */
+		char *location;					/* ( в заголовке функции */
+		std::vector<int> args;
+		std::vector<variable_type> names;	/* кадр, пока генератор стоит на yield */
+		std::vector<int> values;
+		std::vector<call_frame> frames;		/* base, arrays и generators - от начала кадра */
+		std::vector<owned_array> owned;		/* локальные массивы кадра */
+		std::vector<int> owned_generators;	/* генераторы, созданные в кадре */
+		int base = 0;					/* где кадр лежит, пока генератор идет */
+		int depth = 0;
+		int arrays = 0;
+		int generators = 0;
+		char *native_stack_base = nullptr;
+		long native_stack_limit = 0;
+		parse_state parse{};			/* где тело остановилось на yield */
+		int value = 0;					/* что отдал yield или return */
+		int jump = 0;					/* тело прервано: RUN_ABORTED или RUN_ENDED */
+		bool running = false;
+		bool finished = false;
+	};
+	/// Генераторы запуска: описатель в программе - индекс здесь. Генератором, как
+	/// локальным массивом, владеет кадр, где его создали: при возврате из кадра
+	/// генератор освобождается, а описатель идет в free_generators. Описатель,
+	/// который функция возвращает, переходит к вызывающему кадру. У закончившегося
+	/// генератора сразу освобождается стек, next() для него возвращает 0
+	std::vector<std::unique_ptr<generator>> generators;
+	std::vector<int> free_generators;
+	/// Генераторы кадров вызова подряд; кадр владеет ими с call_frame::generators
+	std::vector<int> frame_generators;
+	generator *current_generator = nullptr;
+	size_t generator_stack_size = 1 << 20;
+
+	/**
+	 * @param location точка входа функции-генератора
+	 * @return описатель для next()
+	 */
+	int make_generator(char *location, const int *args, int count)
+	{
+		int handle;
+
+		if (free_generators.empty())
+		{
+			generators.emplace_back();
+			handle = (int)generators.size() - 1;
+		}
+		else
+		{
+			handle = free_generators.back();
+			free_generators.pop_back();
+		}
+		generators[handle] = std::make_unique<generator>();
+		generators[handle]->location = location;
+		generators[handle]->args.assign(args, args + count);
+		frame_generators.push_back(handle);
+		return handle;
+	}
+	generator *find_generator(int handle)
+	{
+		if (handle < 0 || handle >= (int)generators.size() || !generators[handle])
+			runtime_error(PARAM_ERR);
+		return generators[handle].get();
+	}
+	/**
+	 * Освободить генераторы кадров с номера first в frame_generators
+	 */
+	void release_frame_generators(int first)
+	{
+		while ((int)frame_generators.size() > first)
+		{
+			release_generator(frame_generators.back());
+			frame_generators.pop_back();
+		}
+	}
+	/**
+	 * Освободить генератор вместе с массивами и генераторами кадра, на котором
+	 * он стоит в yield
+	 */
+	void release_generator(int handle)
+	{
+		std::unique_ptr<generator> released = std::move(generators[handle]);
+
+		for (owned_array &array : released->owned)
+		{
+			arrays[array.handle].reset();
+			free_arrays.push_back(array.handle);
+		}
+		for (int owned : released->owned_generators)
+			release_generator(owned);
+		free_generators.push_back(handle);
+	}
+	/**
+	 * return описателя генератора, созданного в кадре функции: генератор
+	 * переходит к вызывающему кадру
+	 */
+	void return_generator(int handle)
+	{
+		call_frame &frame = call_stack[function_last_index_on_call_stack - 1];
+
+		for (int i = frame.generators; i < (int)frame_generators.size(); i++)
+			if (frame_generators[i] == handle)
+			{
+				std::swap(frame_generators[i], frame_generators[frame.generators]);
+				frame.generators++;
+				return;
+			}
+	}
+	/**
+	 * Стек для первого next(). mmap может не дать память (кончились адреса
+	 * или vm.max_map_count) - это ошибка программы, а не исключение в хосте
+	 */
+	void make_generator_stack(generator *body)
+	{
+		bool allocated = true;
+
+		try
+		{
+			body->stack = std::make_unique<fiber>(generator_stack_size);
+		}
+		catch (const std::bad_alloc &)
+		{
+			allocated = false;
+		}
+		if (!allocated)
+			runtime_error(NO_MEMORY);
+		getcontext(&body->stack->script);
+		body->stack->script.uc_stack.ss_sp = body->stack->stack;
+		body->stack->script.uc_stack.ss_size = body->stack->size;
+		body->stack->script.uc_link = &body->stack->host;
+		makecontext(&body->stack->script, (void (*)())generator_entry, 2,
+					(unsigned)((uintptr_t)this >> 32), (unsigned)(uintptr_t)this);
+	}
+	/**
+	 * next(описатель) - выполнять генератор до следующего yield
+	 * @return значение yield; когда функция закончилась - ее результат, потом 0
+	 */
+	int next_value(int handle)
+	{
+		generator *resumed = find_generator(handle), *caller_generator = current_generator;
+		char *caller_stack_base = native_stack_base;
+		long caller_stack_limit = native_stack_limit;
+		parse_state caller;
+		jmp_buf caller_errors;
+		int value, jump;
+		bool started;
+
+		if (resumed->finished)
+			return 0;
+		if (resumed->running)
+			runtime_error(GENERATOR_RUNNING);
+		started = resumed->stack != nullptr;
+		if (!started)
+			make_generator_stack(resumed);
+
+		/* кадр генератора - на вершину стеков, где бы она сейчас ни была */
+		resumed->base = lvartos;
+		resumed->depth = function_last_index_on_call_stack;
+		resumed->arrays = (int)frame_arrays.size();
+		resumed->generators = (int)frame_generators.size();
+		for (size_t i = 0; i < resumed->names.size(); i++)
+		{
+			local_push(nullptr, resumed->names[i].variable_type, resumed->values[i]);
+			local_var_stack[lvartos - 1].name_id = resumed->names[i].name_id;
+		}
+		frame_arrays.insert(frame_arrays.end(), resumed->owned.begin(), resumed->owned.end());
+		frame_generators.insert(frame_generators.end(), resumed->owned_generators.begin(), resumed->owned_generators.end());
+		resumed->owned.clear();
+		resumed->owned_generators.clear();
+		for (call_frame &frame : resumed->frames)
+		{
+			function_push_variables_on_call_stack(resumed->base + frame.base, frame.return_location);
+			call_stack[function_last_index_on_call_stack - 1].arrays = resumed->arrays + frame.arrays;
+			call_stack[function_last_index_on_call_stack - 1].generators = resumed->generators + frame.generators;
+		}
+
+		save_parse_state(caller);
+		memcpy(caller_errors, execution_buffer, sizeof(jmp_buf));
+		if (started)
+		{
+			memcpy(execution_buffer, resumed->errors, sizeof(jmp_buf));
+			native_stack_base = resumed->native_stack_base;
+			native_stack_limit = resumed->native_stack_limit;
+		}
+		resumed->running = true;
+		current_generator = resumed;
+		swapcontext(&resumed->stack->host, &resumed->stack->script);
+
+		/* тело дошло до yield или закончилось и уже убрало свой кадр */
+		resumed->running = false;
+		current_generator = caller_generator;
+		native_stack_base = caller_stack_base;
+		native_stack_limit = caller_stack_limit;
+		memcpy(execution_buffer, caller_errors, sizeof(jmp_buf));
+		restore_parse_state(caller);
+		value = resumed->value;
+		if (!resumed->finished)
+			return value;
+		jump = resumed->jump;
+		resumed->stack.reset();
+		if (jump)
+			longjmp(execution_buffer, jump); /* сообщение уже напечатано внутри тела */
+		return value;
+	}
+	/// done(описатель) - 1, если генератор закончился
+	int generator_done(int handle)
+	{
+		return find_generator(handle)->finished;
+	}
+	/**
+	 * Начало стека генератора, this приходит двумя половинами, как в fiber_entry()
+	 */
+	static void generator_entry(unsigned high, unsigned low)
+	{
+		auto self = (LittleC *)(((uintptr_t)high << 32) | low);
+
+		self->run_generator(self->current_generator);
+	}
+	void run_generator(generator *body)
+	{
+		char here;
+		int count;
+
+		switch (setjmp(body->errors))
+		{
+			case RUN_ABORTED:
+				body->jump = RUN_ABORTED;
+				break;
+			case RUN_ENDED:
+				body->jump = RUN_ENDED;
+				break;
+			default:
+				memcpy(execution_buffer, body->errors, sizeof(jmp_buf));
+				body->native_stack_base = native_stack_base = &here;
+				body->native_stack_limit = native_stack_limit =
+						(long)body->stack->size - std::min((long)body->stack->size / 4, 256L << 10);
+				for (count = (int)body->args.size() - 1; count >= 0; count--)
+					local_push(nullptr, ARG, body->args[count]);
+				function_push_variables_on_call_stack(body->base, nullptr);
+				source_code_location = body->location;
+				interpret_function_body();
+				body->value = ret_value;
+		}
+		lvartos = body->base;
+		function_last_index_on_call_stack = body->depth;
+		release_frame_arrays(body->arrays);
+		release_frame_generators(body->generators);
+		body->finished = true;
+		/* дальше uc_link - обратно в next() */
+	}
+	/**
+	 * yield выражение; - отдать значение в next() и ждать следующего next()
+	 */
+	void exec_yield()
+	{
+		generator *body = current_generator;
+		int value;
+
+		eval_expression(&value);
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+		if (!body || function_last_index_on_call_stack != body->depth + 1)
+			runtime_error(YIELD_OUTSIDE);
+
+		body->value = value;
+		save_parse_state(body->parse);
+		body->names.assign(local_var_stack.begin() + body->base, local_var_stack.begin() + lvartos);
+		body->values.assign(local_values.begin() + body->base, local_values.begin() + lvartos);
+		body->frames.assign(call_stack.begin() + body->depth, call_stack.begin() + function_last_index_on_call_stack);
+		body->owned.assign(frame_arrays.begin() + body->arrays, frame_arrays.end());
+		body->owned_generators.assign(frame_generators.begin() + body->generators, frame_generators.end());
+		for (call_frame &frame : body->frames)
+		{
+			frame.base -= body->base;
+			frame.arrays -= body->arrays;
+			frame.generators -= body->generators;
+		}
+		lvartos = body->base;
+		function_last_index_on_call_stack = body->depth;
+		frame_arrays.resize(body->arrays);
+		frame_generators.resize(body->generators);
+		swapcontext(&body->stack->script, &body->stack->host);
+
+		/* next() вернул кадр на стек, возможно в другое место */
+		restore_parse_state(body->parse);
+	}
+	/**
+	 * @param location точка входа функции
+	 * @return true, если в теле функции есть yield
+	 */
+	bool is_generator(const char *location)
+	{
+		for (int function = 0; function < function_position; function++)
+			if (function_table[function].loc == location)
+				return function_table[function].generator;
+		return false;
+	}
+	/**
+	 * @param location точка входа функции
+	 * @return тип, который функция возвращает
+	 */
+	int function_type_at(const char *location)
+	{
+		for (int function = 0; function < function_position; function++)
+			if (function_table[function].loc == location)
+				return function_table[function].ret_type;
+		return INT;
+	}
+	/**
+	 * Сообщение интерпретатора, если хост их не отключил (print_errors)
+	 */
+	void report(const std::string &message)
+	{
+		if (!print_errors)
+			return;
+		flush_output();
+		std::cout << message << std::endl;
+	}
+
+	/**
+	 * Загрузить программу в память
+	 * @param text
+	 * @param fname
+	 * @return
+	 */
+	int load_program(std::string &text, const std::string& fname)
+	{
+		std::ifstream file(path + fname, std::ios::binary);
+
+		if (!file)
+			return 0;
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		/// Рудимент из бейсика. Ставится в конце исполняемого файла
+		if (!text.empty() && text.back() == 0x1a)
+			text.pop_back(); /* конец строки завершает программу */
+		return 1;
+	}
+	/**
+	 * Найти адреса всех функций и запомнить глобальные переменные
+	 */
+	void prescan_source_code()
+	{
+		/// *p - указатель на указатель ? (На source_code_location). temp_source_code_location тоже указатель на source_code_location???
+		char *initial_source_code_location, *temp_source_code_location;
+		char temp_token[ID_LEN + 1];
+		int datatype;
+		/// Если is_brace_open = 0, о текущая позиция указателя программы находится в не какой-либо функции
+		int is_brace_open = 0;
+
+		initial_source_code_location = source_code_location;
+		function_position = 0;
+		do
+		{
+			while (is_brace_open)
+			{ /* обхода кода функции внутри фигурных скобок */
+				get_next_token();
+				if (*current_token == '{') //когда встречаем открывающую скобку, увеличиваем is_brace_open на один
+					is_brace_open++;
+				if (*current_token == '}')
+					is_brace_open--; //когда встречаем закрывающую уменьшаем на один
+				if (!is_brace_open && function_position)
+					function_table[function_position - 1].end = source_code_location;
+				if (token_type == KEYWORD && current_tok_datatype == YIELD && function_position)
+					function_table[function_position - 1].generator = true;
+			}
+
+			temp_source_code_location = source_code_location; /* запоминаем текущую позицию */
+			get_next_token();
+			/* тип глобальной переменной или возвращаемого значения функции */
+			if (current_tok_datatype == CHAR || current_tok_datatype == INT || current_tok_datatype == LONG ||
+				current_tok_datatype == STR)
+			{
+				datatype = current_tok_datatype; /* сохраняем тип данных */
+				get_next_token();
+				if (token_type == VARIABLE)
+				{
+					//
+					strcpy_s(temp_token, ID_LEN + 1, current_token);
+					get_next_token();
+					if (*current_token != '(')
+					{													  /* должно быть глобальной переменной */
+						source_code_location = temp_source_code_location; /* вернуться в начало объявления */
+						declare_global_variables();
+					}
+					else if (*current_token == '(')
+					{ /* должно быть функцией */
+						function_table[function_position].loc = source_code_location;
+						function_table[function_position].ret_type = datatype;
+						function_table[function_position].end = nullptr;
+						function_table[function_position].analyzed = 0;
+						function_table[function_position].constants.clear();
+						function_table[function_position].arrays.clear();
+						function_table[function_position].long_names.clear();
+						function_table[function_position].long_arrays.clear();
+						function_table[function_position].unsure_names.clear();
+						function_table[function_position].string_names.clear();
+						function_table[function_position].mixed_string_names.clear();
+						function_table[function_position].inline_state = 0;
+						function_table[function_position].inline_body = nullptr;
+						function_table[function_position].generator = false;
+						strcpy_s(function_table[function_position].func_name, ID_LEN, temp_token);
+						function_position++;
+						while (*source_code_location != ')')
+							source_code_location++;
+						source_code_location++;
+						/* сейчас source_code_location указывает на открывающуюся
+						   фигурную скобку функции */
+					}
+					else
+						shift_source_code_location_back();
+				}
+			}
+			else if (*current_token == '{')
+				is_brace_open++;
+		} while (current_tok_datatype != FINISHED);
+		source_code_location = initial_source_code_location;
+	}
+	/**
+	 * Передвигаем указатель на текущую программу на *_токен_* обратно
+	 *
+	 * Return a current_token to input stream.
+	 */
+	void shift_source_code_location_back()
+	{
+		char *t;
+
+		t = current_token;
+		for (; *t; t++)
+			source_code_location--;
+	}
+	/**
+	 * Объявление глобальной переменной в ИНТЕРПРЕТИРУЕМОЙ программе
+	 *
+	 * Данные хранятся в списке global vars
+	 */
+	void declare_global_variables()
+	{
+		int variable_type;
+
+		get_next_token(); /* получаем тип данных */
+
+		variable_type = current_tok_datatype; /* запоминаем тип данных */
+
+		do
+		{ /* обработка списка с разделителями запятыми */
+			global_vars[global_variable_position].variable_type = variable_type;
+			global_values[global_variable_position] = 0; /* инициализируем нулем */
+			global_lengths[global_variable_position] = 0;
+			get_next_token();							 /* определяем имя */
+			global_vars[global_variable_position].name_id = variable_id(current_token);
+			get_next_token();
+			if (*current_token == '[')
+			{ /* массив создает make_global_arrays() перед запуском */
+				if (variable_type == STR)
+					syntax_error(SYNTAX); /* массивов строк нет */
+				global_lengths[global_variable_position] = read_array_length();
+				if (!global_lengths[global_variable_position])
+					syntax_error(ARRAY_SIZE);
+			}
+			global_variable_position++;
+		} while (*current_token == ',');
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+	}
+	/**
+	 * @brief Печать ошибки
+	 *
+	 * Выводит сообщение об ошибке, основываясь на полученном типе ошибки
+	 * @param error_type
+	 */
+	void syntax_error(int error_type)
+	{
+		std::string errors_human_readable[]
+				{
+						"Синтаксическая ошибка",
+						"Слишком много или мало скобок",
+						"Нет выражения",
+						"Не хватает знаков равно",
+						"Не является переменной",
+						"Параметрическая ошибка",
+						"Не хватает точки с запятой",
+						"Слишком много или мало операторных скобок",
+						"Функция не определена",
+						"Нужно указать тип данных",
+						"Слишком много обращений к вложенным функциям",
+						"Функция возвращает значения без обращения к ней",
+						"Не хватает скобки",
+						"Нет оператора для цикла while",
+						"Не хватает закрывающих кавычек",
+						"Не является строкой",
+						"Слишком много локальных переменных",
+						"На ноль делить НЕЛЬЗЯ",
+						"Кончился лимит шагов",
+						"Из parfor нельзя выйти через break или return",
+						"Генератор уже выполняется",
+						"yield вне генератора",
+						"Это не массив",
+						"Индекс за границами массива",
+						"Размер массива - целая константа от 1 до max_array_size",
+						"Массиву нельзя присвоить значение, только его элементам",
+						"Переполнение целого",
+						"Здесь может быть только int",
+						"Не хватает памяти"
+				};
+
+		/// Репрезентация ошибок анализатора в понятном для человека виде
+
+		last_error = error_type;
+		if (!print_errors)
+			return;
+		flush_output(); /* сообщение должно идти после того, что программа уже напечатала */
+		std::cout << "\n" << errors_human_readable[error_type];
+	}
+	/**
+	 * Получить текущий символ
+	 * @return
+	 */
+	char get_next_token()
+	{
+		char *temp_token;
+
+		token_type = 0;
+		current_tok_datatype = 0;
+
+		temp_token = current_token;
+		*temp_token = '\0';
+		//обработка конца строки для мака и для винды
+		//на самом деле это все спокойно можно заменить на SUB из Бейсика,
+		//потому что он до сих пор поддерживается в новых ЯП как спецсимвол
+		/* skip over white space */
+		while (is_whitespace(*source_code_location) && *source_code_location)
+			++source_code_location;
+
+		/* Handle Windows and Mac newlines */
+		if (*source_code_location == '\r')
+		{
+			++source_code_location;
+			/* Only skip \n if it exists (if it doesn't, we are running on mac) */
+			if (*source_code_location == '\n')
+			{
+				++source_code_location;
+			}
+			/* skip over white space */
+			while (is_whitespace(*source_code_location) && *source_code_location)
+				++source_code_location;
+		}
+
+		/* Handle Unix newlines */
+		if (*source_code_location == '\n')
+		{
+			++source_code_location;
+			/* skip over white space */
+			while (is_whitespace(*source_code_location) && *source_code_location)
+				++source_code_location;
+		}
+
+		if (*source_code_location == '\0')
+		{ /* end of file */
+			*current_token = '\0';
+			current_tok_datatype = FINISHED;
+			return (token_type = DELIMITER);
+		}
+
+		// https://www.cplusplus.com/reference/cstring/strchr/
+		// strchr - Returns a pointer to the first occurrence of character in the C string str
+		/*
+		этот кусок находит блоки кода типа
+		int function(.....)
+		{
+			все что написано тут, оно находит и помечает как токен BLOCK
+		}
+		*/
+		if (strchr("{}", *source_code_location))
+		{ /* block delimiters */
+			*temp_token = *source_code_location;
+			temp_token++;
+			*temp_token = '\0';
+			source_code_location++;
+			return (token_type = BLOCK);
+		}
+
+		/* поиск комментариев */
+		if (*source_code_location == '/')
+			if (*(source_code_location + 1) == '*')
+			{ /* найти конец комментария  */
+				source_code_location += 2;
+				do
+				{
+					while (*source_code_location != '*' && *source_code_location != '\0')
+						source_code_location++;
+					if (*source_code_location == '\0')
+					{
+						source_code_location--;
+						break;
+					}
+					source_code_location++;
+				} while (*source_code_location != '/');
+				source_code_location++;
+			}
+
+		/* look for C++ style comments */
+		if (*source_code_location == '/')
+			if (*(source_code_location + 1) == '/')
+			{ /* is a comment */
+				source_code_location += 2;
+				/* find end of line */
+				while (*source_code_location != '\r' && *source_code_location != '\n' && *source_code_location != '\0')
+					source_code_location++;
+				if (*source_code_location == '\r' && *(source_code_location + 1) == '\n')
+				{
+					source_code_location++;
+				}
+			}
+
+		/* look for the end of file after a comment */
+		if (*source_code_location == '\0')
+		{ /* end of file */
+			*current_token = '\0';
+			current_tok_datatype = FINISHED;
+			return (token_type = DELIMITER);
+		}
+
+		if (strchr("!<>=", *source_code_location))
+		{ /* is or might be
+        a relational operator */
+			switch (*source_code_location)
+			{
+				case '=':
+					if (*(source_code_location + 1) == '=')
+					{
+						source_code_location++;
+						source_code_location++;
+						*temp_token = EQUAL;
+						temp_token++;
+						*temp_token = EQUAL;
+						temp_token++;
+						*temp_token = '\0';
+					}
+					break;
+				case '!':
+					if (*(source_code_location + 1) == '=')
+					{
+						source_code_location++;
+						source_code_location++;
+						*temp_token = NOT_EQUAL;
+						temp_token++;
+						*temp_token = NOT_EQUAL;
+						temp_token++;
+						*temp_token = '\0';
+					}
+					break;
+				case '<':
+					if (*(source_code_location + 1) == '=')
+					{
+						source_code_location++;
+						source_code_location++;
+						*temp_token = LOWER_OR_EQUAL;
+						temp_token++;
+						*temp_token = LOWER_OR_EQUAL;
+					}
+					else
+					{
+						source_code_location++;
+						*temp_token = LOWER;
+					}
+					temp_token++;
+					*temp_token = '\0';
+					break;
+				case '>':
+					if (*(source_code_location + 1) == '=')
+					{
+						source_code_location++;
+						source_code_location++;
+						*temp_token = GREATER_OR_EQUAL;
+						temp_token++;
+						*temp_token = GREATER_OR_EQUAL;
+					}
+					else
+					{
+						source_code_location++;
+						*temp_token = GREATER;
+					}
+					temp_token++;
+					*temp_token = '\0';
+					break;
+			}
+			if (*current_token)
+				return (token_type = DELIMITER);
+		}
+
+		if (strchr("+-*^/%=;(),'[]", *source_code_location))
+		{ /* delimiter */
+			*temp_token = *source_code_location;
+			source_code_location++; /* advance to next position */
+			temp_token++;
+			*temp_token = '\0';
+			return (token_type = DELIMITER);
+		}
+
+		if (*source_code_location == '"')
+		{ /* Обработка строки в кавычках */
+			source_code_location++;
+			while ((*source_code_location != '"' &&
+					*source_code_location != '\r' &&
+					*source_code_location != '\n' &&
+					*source_code_location != '\0') ||
+				   (*source_code_location == '"' &&
+					*(source_code_location - 1) == '\\'))
+				*temp_token++ = *source_code_location++;
+
+			if (*source_code_location == '\r' || *source_code_location == '\n' || *source_code_location == '\0')
+				syntax_error(SYNTAX);
+			source_code_location++;
+			*temp_token = '\0';
+			str_replace(current_token, "\\a", "\a");
+			str_replace(current_token, "\\b", "\b");
+			str_replace(current_token, "\\f", "\f");
+			str_replace(current_token, "\\n", "\n");
+			str_replace(current_token, "\\r", "\r");
+			str_replace(current_token, "\\t", "\t");
+			str_replace(current_token, "\\v", "\v");
+			str_replace(current_token, "\\\\", "\\");
+			str_replace(current_token, "\\\'", "\'");
+			str_replace(current_token, "\\\"", "\"");
+			return (token_type = STRING);
+		}
+
+		// передаем на вход начало строки, где мы находимся и проверям не число ли это.
+		// если число, то считываем его до тех пор пока не встретим разделитель
+		if (isdigit((int)*source_code_location))
+		{ /* number */
+			while (!is_delimiter(*source_code_location))
+				*temp_token++ = *source_code_location++;
+			*temp_token = '\0';
+			return (token_type = NUMBER);
+		}
+
+		// передаем на вход начало строки, где мы находимся и проверям не буква ли это.
+		// если буква, то считываем его до тех пор пока не встретим разделитель
+		// так мы сможем выделить команду или название переменной.
+		if (isalpha((int)*source_code_location))
+		{ /* var or command */
+			while (!is_delimiter(*source_code_location))
+				*temp_token++ = *source_code_location++;
+			token_type = TEMP;
+		}
+
+		*temp_token = '\0';
+
+		/* see if a string is a command or a variable */
+		if (token_type == TEMP)
+		{
+			current_tok_datatype = look_up_token_in_table(current_token); /* convert to internal rep */
+			// если тип не 0, то есть токен является специальным словом
+			// иначе же это переменная
+			if (current_tok_datatype)
+				token_type = KEYWORD; /* is a keyword */
+			else
+				token_type = VARIABLE;
+		}
+		return token_type;
+	}
+	/**
+	 * Ищет текущий токен в специальной таблице с зарезервированными словами
+	 * @param token_string
+	 * @return
+	 */
+	char look_up_token_in_table(char *token_string)
+	{
+		int i;
+		char *pointer_to_token_string;
+
+		/* переводим токен в нижний регистр */
+		pointer_to_token_string = token_string;
+		while (*pointer_to_token_string)
+		{
+			*pointer_to_token_string = (char)tolower(*pointer_to_token_string);
+			pointer_to_token_string++;
+		}
+
+		/* проверяем есть ли данный токен в таблице специальных зарезервированных слов. */
+		for (i = 0; *table_with_statements[i].command; i++)
+		{
+			if (!strcmp(table_with_statements[i].command, token_string))
+				return table_with_statements[i].tok;
+		}
+		return 0; /* unknown command */
+	}
+	/**
+	 * Return 1 if c is space or tab.
+	 * @param c
+	 * @return
+	 */
+	static int is_whitespace(char c)
+	{
+		if (c == ' ' || c == '\t')
+			return 1;
+		else
+			return 0;
+	}
+	/**
+	 * @brief Разделитель
+	 *
+	 * Проверяет является ли символ разделителем
+	 *
+	 * @param Символ
+	 *
+	 * @return 1 - разделитель
+	 * 0 - не разделитель
+	 */
+	static int is_delimiter(char c)
+	{
+		if (strchr(" !;,+-<>'/*%^=()[]", c) || c == 9 ||
+			c == '\r' || c == '\n' || c == 0)
+			return 1;
+		return 0;
+	}
+	/**
+	 * Модификация на месте находит и заменяет строку
+	 *
+	 * Предполагается, что буфер, на который указывает строка, достаточно велик для хранения результирующей строки
+	 * @param line
+	 * @param search
+	 * @param replace
+	 */
+	static void str_replace(char *line, const char *search, const char *replace)
+	{
+		char *sp;
+		while ((sp = strstr(line, search)) != nullptr)
+		{
+			int search_len = (int)strlen(search);
+			int replace_len = (int)strlen(replace);
+			int tail_len = (int)strlen(sp + search_len);
+
+			memmove(sp + replace_len, sp + search_len, tail_len + 1);
+			memcpy(sp, replace, replace_len);
+		}
+	}
+	/**
+	 * Return the entry point of the specified function
+	 * @param name
+	 * @return NULL if not found
+	 */
+	char *find_function_in_function_table(const char *name)
+	{
+		int function_pos;
+
+		for (function_pos = 0; function_pos < function_position; function_pos++)
+			if (!strcmp(name, function_table[function_pos].func_name))
+				return function_table[function_pos].loc;
+
+		return nullptr;
+	}
+
+
+	/// TODO код ниже вынести(?) в отдельный наследуемый класс интерпретатор
+	/// TODO вытащить последний ретерн и вернуть тут!
+	/* Call a function. */
+	void call_function()
+	{
+		char *function_location, *temp_source_code_location;
+		int lvartemp;
+
+		function_location = find_function_in_function_table(current_token); /* find entry point of function */
+		if (function_location == nullptr)
+			syntax_error(FUNC_UNDEFINED); /* function not defined */
+		else
+		{
+			lvartemp = lvartos;								  /* save local var stack index */
+			get_function_arguments();						  /* get function arguments */
+			if (is_generator(function_location))
+			{ /* аргументы лежат в обратном порядке */
+				std::vector<int> args(local_values.rend() - lvartos, local_values.rend() - lvartemp);
+
+				lvartos = lvartemp;
+				ret_value = make_generator(function_location, args.data(), (int)args.size());
+				return;
+			}
+			temp_source_code_location = source_code_location; /* save return location */
+			function_push_variables_on_call_stack(lvartemp, temp_source_code_location); /* save local var stack index */
+			source_code_location = function_location;		  /* reset prog to start of function */
+			interpret_function_body();						  /* interpret the function */
+			source_code_location = temp_source_code_location; /* reset the program initial_source_code_location */
+			lvartos = func_pop();							  /* reset the local var stack */
+		}
+	}
+	/**
+	 * Push the arguments to a function onto the local variable stack
+	 */
+	void get_function_arguments()
+	{
+		int value, count, temp[NUM_PARAMS];
+
+		count = 0;
+		get_next_token();
+		if (*current_token != '(')
+			syntax_error(PAREN_EXPECTED);
+
+		/* process a comma-separated list of values */
+		do
+		{
+			eval_expression(&value);
+			temp[count] = value; /* save temporarily */
+			get_next_token();
+			count++;
+		} while (*current_token == ',');
+		count--;
+		/* now, push on local_var_stack in reverse order */
+		for (; count >= 0; count--)
+			local_push(nullptr, ARG, temp[count]);
+	}
+	/* Парсер хуярсер. */
+	void eval_expression(int *value)
+	{
+		compiled_expression *compiled;
+
+		/* выражение уже разобрано - считаем по дереву, не трогая токенизатор */
+		compiled = compiled_expression_at(source_code_location);
+		if (compiled)
+		{
+			*value = eval_node(compiled->code);
+			skip_compiled_expression(compiled);
+			return;
+		}
+
+		get_next_token();
+		if (!*current_token)
+		{
+			syntax_error(NO_EXP);   //no expression
+			return;
+		}
+		if (*current_token == ';')
+		{
+			*value = 0; /* empty expression */
+			return;
+		}
+		eval_assignment_expression(value);
+		shift_source_code_location_back(); /* return last current_token read to input stream */
+	}
+	/**
+	 * eval_expression() без обрезки значения long до int. Обычный разбор
+	 * считает только int
+	 */
+	void eval_wide_expression(long long *value)
+	{
+		compiled_expression *compiled;
+		int narrow;
+
+		compiled = compiled_expression_at(source_code_location);
+		if (compiled)
+		{
+			*value = compiled->code->op == OP_WIDE ? eval_wide(compiled->code->left) : eval_node(compiled->code);
+			skip_compiled_expression(compiled);
+			return;
+		}
+		eval_expression(&narrow);
+		*value = narrow;
+	}
+	/* Process an assignment expression */
+	void eval_assignment_expression(int *value)
+	{
+		char temp[ID_LEN]; /* holds name of var receiving
+                          the assignment */
+		char temp_tok;
+		int handle, index;
+
+		if (token_type == VARIABLE)
+		{
+			if (is_variable(current_token))
+			{ /* Если встретили переменную, то проверяем, присваивается ли ей какое-либо значение */
+				strcpy_s(temp, ID_LEN, current_token);
+				temp_tok = token_type;
+				get_next_token();
+				if (*current_token == '=')
+				{ /* если присваивается */
+					get_next_token();
+					eval_assignment_expression(value); /* то смотрим, что надо присвоить */
+					assign_var(temp, *value);          /* присваиваем */
+					return;
+				}
+				else if (*current_token == '[' && element_assignment_ahead())
+				{ /* присваивается элементу массива */
+					handle = find_var(temp);
+					index = read_index();
+					get_next_token();
+					eval_assignment_expression(value);
+					store_element(handle, index, *value);
+					return;
+				}
+				else
+				{                                      /* если не присваевается */
+					shift_source_code_location_back(); /* то забываем про temp и копируем изначальное значение токена из temp_tok */
+					strcpy_s(current_token, 80, temp);
+					token_type = temp_tok;
+				}
+			}
+		}
+		eval_exp1(value);
+	}
+	/**
+	 * Determine if an identifier is a variable
+	 * @param s
+	 * @return 1 if variable is found; 0 otherwise
+	 */
+	int is_variable(const char *s)
+	{
+		return lookup_var(known_variable_id(s)) != nullptr;
+	}
+	/**
+	 * Assign a value to a variable
+	 * @param var_name
+	 * @param value
+	 */
+	void assign_var(char *var_name, int value)
+	{
+		int *slot = lookup_var(known_variable_id(var_name));
+
+		if (slot && is_array_variable(known_variable_id(var_name)))
+			runtime_error(ARRAY_ASSIGN);
+		if (slot && variable_type_of(known_variable_id(var_name)) == LONG)
+		{
+			arrays[*slot]->longs[0] = value;
+			return;
+		}
+		if (slot && variable_type_of(known_variable_id(var_name)) == STR)
+		{
+			copy_string(value, *slot);
+			return;
+		}
+		if (slot)
+			*slot = value;
+		else
+			syntax_error(NOT_VAR); /* variable not found */
+	}
+	/**
+	 * За [ в коде до парной ] стоит присваивание =
+	 */
+	bool element_assignment_ahead()
+	{
+		char *p = source_code_location;
+		int depth = 1;
+
+		while (*p && depth)
+		{
+			if (*p == '[')
+				depth++;
+			else if (*p == ']')
+				depth--;
+			p++;
+		}
+		while (is_whitespace(*p) || *p == '\r' || *p == '\n')
+			p++;
+		return *p == '=' && p[1] != '=';
+	}
+	/**
+	 * Индекс в [] без компиляции, current_token - [. Останавливается за ]
+	 */
+	int read_index()
+	{
+		int index;
+
+		get_next_token();
+		eval_assignment_expression(&index);
+		if (*current_token != ']')
+			syntax_error(SYNTAX);
+		get_next_token();
+		return index;
+	}
+	/**
+	 * Process relational operators
+	 * @param value
+	 */
+	void eval_exp1(int *value)
+	{
+		int partial_value;
+		char op;
+		char relops[7] = {
+				LOWER,
+				LOWER_OR_EQUAL,
+				GREATER,
+				GREATER_OR_EQUAL,
+				EQUAL,
+				NOT_EQUAL,
+				0};
+
+		eval_exp2(value);
+		op = *current_token;
+		if (strchr(relops, op))
+		{
+			get_next_token();
+			eval_exp2(&partial_value);
+			switch (op)
+			{ /* perform the relational operation */
+				case LOWER:
+					*value = *value < partial_value;
+					break;
+				case LOWER_OR_EQUAL:
+					*value = *value <= partial_value;
+					break;
+				case GREATER:
+					*value = *value > partial_value;
+					break;
+				case GREATER_OR_EQUAL:
+					*value = *value >= partial_value;
+					break;
+				case EQUAL:
+					*value = *value == partial_value;
+					break;
+				case NOT_EQUAL:
+					*value = *value != partial_value;
+					break;
+			}
+		}
+	}
+	/**
+	 * Add or subtract two terms
+	 * @param value
+	 */
+	void eval_exp2(int *value)
+	{
+		char op;
+		int partial_value;
+
+		eval_exp3(value);
+		while ((op = *current_token) == '+' || op == '-')
+		{
+			get_next_token();
+			eval_exp3(&partial_value);
+			switch (op)
+			{ /* add or subtract */
+				case '-':
+					*value = narrow((long long)*value - partial_value);
+					break;
+				case '+':
+					*value = narrow((long long)*value + partial_value);
+					break;
+			}
+		}
+	}
+	/**
+	 * Multiply or divide two factors
+	 * @param value
+	 */
+	void eval_exp3(int *value)
+	{
+		char op;
+		int partial_value;
+
+		eval_exp4(value);
+		while ((op = *current_token) == '*' || op == '/' || op == '%')
+		{
+			get_next_token();
+			eval_exp4(&partial_value);
+			switch (op)
+			{ /* mul, div, or modulus */
+				case '*':
+					*value = narrow((long long)*value * partial_value);
+					break;
+				case '/':
+					*value = divide(OP_DIV, *value, partial_value);
+					break;
+				case '%':
+					*value = divide(OP_MOD, *value, partial_value);
+					break;
+			}
+		}
+	}
+	/**
+	 * Is a unary + or -
+	 * @param value
+	 */
+	void eval_exp4(int *value)
+	{
+		char op;
+
+		op = '\0';
+		if (*current_token == '+' || *current_token == '-')
+		{
+			op = *current_token;
+			get_next_token();
+		}
+		eval_exp5(value);
+		if (op)
+			if (op == '-')
+				*value = narrow(-(long long)*value);
+	}
+	/**
+	 * Результат арифметики int, посчитанный в 64 битах. В режиме
+	 * checked_arithmetic то, что не влезает в int, - ошибка
+	 */
+	int narrow(long long result)
+	{
+		if (checked_arithmetic && result != (int)result)
+			runtime_error(OVERFLOW);
+		return (int)result;
+	}
+	/**
+	 * Process parenthesized expression
+	 * @param value
+	 */
+	void eval_exp5(int *value)
+	{
+		if (*current_token == '(')
+		{
+			get_next_token();
+			eval_assignment_expression(value); /* get subexpression */
+			if (*current_token != ')')
+				syntax_error(PAREN_EXPECTED);
+			get_next_token();
+		}
+		else
+			atom(value);
+	}
+	/**
+	 * Find value of number, variable, or function
+	 * @param value
+	 */
+	void atom(int *value)
+	{
+		int i;
+
+		switch (token_type)
+		{
+			case VARIABLE:
+				i = internal_func(current_token);
+				if (i != -1)
+				{
+					*value = (this->*intern_func[i].p)();
+				}
+				else if ((i = native_call(current_token)) != -1)
+				{
+					*value = call_native_function(i);
+				}
+				else if (find_function_in_function_table(current_token))
+				{ /* call user-defined function */
+					call_function();
+					*value = ret_value;
+				}
+				else
+				{
+					*value = find_var(current_token); /* get var's value */
+					get_next_token();
+					if (*current_token == '[')
+						*value = element(*value, read_index());
+					return;
+				}
+				get_next_token();
+				return;
+			case NUMBER: /* is numeric constant */
+				*value = atoi(current_token);
+				get_next_token();
+				return;
+			case STRING: /* строка - значение, которое живет до конца инструкции */
+				*value = new_string(current_token, (int)strlen(current_token));
+				get_next_token();
+				return;
+			case DELIMITER: /* see if character constant */
+				if (*current_token == '\'')
+				{
+					*value = *source_code_location;
+					source_code_location++;
+					if (*source_code_location != '\'')
+						syntax_error(QUOTE_EXPECTED);
+					source_code_location++;
+					get_next_token();
+					return;
+				}
+				if (*current_token == ')')
+					return; /* process empty expression */
+				else
+					syntax_error(SYNTAX); /* syntax error */
+			default:
+				syntax_error(SYNTAX); /* syntax error */
+		}
+	}
+	/**
+	 * Вызвать встроенную функцию, разбирая аргументы из кода (когда выражение
+	 * не удалось скомпилировать). Останавливается за )
+	 * @param index номер в natives
+	 * @return
+	 */
+	int call_native_function(int index)
+	{
+		int args[NUM_PARAMS], count = 0;
+
+		get_next_token();
+		if (*current_token != '(')
+			syntax_error(PAREN_EXPECTED);
+		get_next_token();
+		if (*current_token != ')')
+		{
+			shift_source_code_location_back();
+			do
+			{
+				if (count == NUM_PARAMS)
+					runtime_error(PARAM_ERR);
+				eval_expression(&args[count++]);
+				get_next_token();
+			} while (*current_token == ',');
+			if (*current_token != ')')
+				syntax_error(PAREN_EXPECTED);
+		}
+		if (count != natives[index].arity)
+		{
+			syntax_error(PARAM_ERR);
+			return 0;
+		}
+		return natives[index].call(args);
+	}
+	/**
+	 * Return index of internal library function or -1 if not found
+	 * @param s
+	 * @return
+	 */
+	int internal_func(const char *s)
+	{
+		int i;
+
+		for (i = 0; intern_func[i].f_name[0]; i++)
+		{
+			if (!strcmp(intern_func[i].f_name, s))
+				return i;
+		}
+		return -1;
+	}
+	/**
+	 * Номер имени переменной; новое имя получает следующий номер
+	 * @param name
+	 * @return
+	 */
+	int variable_id(const char *name)
+	{
+		auto [it, inserted] = variable_ids.try_emplace(name, (int)variable_names.size());
+
+		if (inserted)
+			variable_names.emplace_back(name);
+		return it->second;
+	}
+	/**
+	 * Номер имени, не заводя новый
+	 * @param name
+	 * @return -1, если такого имени еще не было
+	 */
+	int known_variable_id(const char *name)
+	{
+		auto it = variable_ids.find(name);
+
+		return it == variable_ids.end() ? -1 : it->second;
+	}
+	/**
+	 * Where the value of a variable is stored. Сначала локальные переменные
+	 * текущего кадра, потом глобальные; просматриваются только номера имен
+	 * @param name_id
+	 * @return nullptr, если переменной нет
+	 */
+	int *lookup_var(int name_id)
+	{
+		int i;
+
+		if (name_id < 0)
+			return nullptr;
+
+		for (i = lvartos - 1; i >= frame_base(); i--)
+			if (local_var_stack[i].name_id == name_id)
+				return &local_values[i];
+
+		for (i = 0; i < global_variable_position; i++)
+			if (global_vars[i].name_id == name_id)
+				return &global_values[i];
+
+		return nullptr;
+	}
+	/**
+	 * Find where the value of a variable is stored
+	 * @param name_id
+	 * @return
+	 */
+	int *find_var_slot(int name_id)
+	{
+		int *slot = lookup_var(name_id);
+
+		if (slot)
+			return slot;
+		syntax_error(NOT_VAR); /* variable not found */
+		missing_variable = -1;
+		return &missing_variable;
+	}
+	/**
+	 * Find the value of a variable
+	 * @param s
+	 * @return
+	 */
+	int find_var(const char *s)
+	{
+		long long *cell = long_cell(known_variable_id(s));
+
+		return cell ? (int)*cell : *find_var_slot(known_variable_id(s));
+	}
+	/**
+	 * Push a local variable
+	 * @param name имя или nullptr для аргумента, которому имя даст get_function_parameters()
+	 * @param type
+	 * @param value
+	 */
+	void local_push(const char *name, int type, int value)
+	{
+		if (lvartos >= max_local_vars)
+			runtime_error(TOO_MANY_LVARS);
+		if (lvartos == (int)local_values.size())
+		{
+			local_var_stack.emplace_back();
+			local_values.push_back(0);
+		}
+		local_var_stack[lvartos].name_id = name ? variable_id(name) : -1;
+		local_var_stack[lvartos].variable_type = type;
+		local_values[lvartos] = value;
+		lvartos++;
+	}
+	/**
+	 * Push index of local variable stack.
+	 * добавляет локальные переменные функции в стек
+	 * @param i первый слот кадра
+	 * @param return_location куда вернуться после вызова
+	 */
+	void function_push_variables_on_call_stack(int i, char *return_location)
+	{
+		char here;
+
+		if (function_last_index_on_call_stack >= max_call_depth ||
+			native_stack_base - &here > native_stack_limit)
+			runtime_error(NESTED_FUNCTIONS);
+		if (function_last_index_on_call_stack == (int)call_stack.size())
+			call_stack.push_back(call_frame{});
+		call_stack[function_last_index_on_call_stack].base = i;
+		call_stack[function_last_index_on_call_stack].return_location = return_location;
+		call_stack[function_last_index_on_call_stack].arrays = (int)frame_arrays.size();
+		call_stack[function_last_index_on_call_stack].generators = (int)frame_generators.size();
+		function_last_index_on_call_stack++;
+	}
+	/**
+	 * Первый слот локальных переменных текущей функции
+	 */
+	int frame_base()
+	{
+		return function_last_index_on_call_stack ? call_stack[function_last_index_on_call_stack - 1].base : lvartos;
+	}
+	/**
+	 * Ошибка, после которой выполнять программу дальше нельзя: печатаем ее
+	 * и возвращаемся из execute() с кодом 1.
+	 * Возврат идет через longjmp, деструкторы по дороге не вызываются: в момент
+	 * вызова в интерпретаторе не должно быть живых lock_guard, vector, string и т.п.
+	 * @param error_type
+	 */
+	void runtime_error(int error_type)
+	{
+		syntax_error(error_type);
+		longjmp(execution_buffer, RUN_ABORTED);
+	}
+	/**
+	 * Сколько native-стека отдать рекурсии интерпретатора: остаток стека текущего
+	 * потока (у потоков хоста он бывает намного меньше RLIMIT_STACK) без запаса
+	 * на библиотечные вызовы
+	 */
+	void set_native_stack_limit()
+	{
+		struct rlimit limit{};
+		pthread_attr_t attributes;
+		void *stack_low;
+		size_t stack_size;
+		long left = 0;
+		char here;
+
+		native_stack_base = &here;
+		native_stack_limit = 64L << 20;
+		if (state == CONTEXT_RUNNING)
+		{
+			native_stack_limit = (long)running_fiber->size - std::min((long)running_fiber->size / 4, 256L << 10);
+			return;
+		}
+		if (!pthread_getattr_np(pthread_self(), &attributes))
+		{
+			if (!pthread_attr_getstack(&attributes, &stack_low, &stack_size))
+				left = &here - (char *)stack_low;
+			pthread_attr_destroy(&attributes);
+		}
+		if (left <= 0 && !getrlimit(RLIMIT_STACK, &limit) && limit.rlim_cur != RLIM_INFINITY)
+			left = (long)limit.rlim_cur;
+		if (left > 0)
+			native_stack_limit = left - std::min(left / 4, 256L << 10);
+	}
+	/**
+	 * Get function parameters.
+	 */
+	void get_function_parameters()
+	{
+		struct variable_type *variable_type_pointer;
+		int position;
+
+		position = lvartos - 1;
+		if (string_functions)
+			call_stack[function_last_index_on_call_stack - 1].returns_string = function_type_at(source_code_location) == STR;
+		do
+		{ /* process comma-separated list of parameters */
+			get_next_token();
+			if (*current_token != ')')
+			{
+				/// аргументов меньше, чем параметров
+				if (position < frame_base())
+					runtime_error(PARAM_ERR);
+				variable_type_pointer = &local_var_stack[position];
+				if (current_tok_datatype == LONG)
+					runtime_error(NOT_INT); /* аргументы передаются как int */
+				if (current_tok_datatype == STR)
+				{ /* строку функция получает своей копией, как переменную string */
+					variable_type_pointer->variable_type = STR;
+					local_values[position] = copy_string(local_values[position], local_array(STR, 0, source_code_location));
+				}
+				else if (current_tok_datatype != INT && current_tok_datatype != CHAR)
+					syntax_error(TYPE_EXPECTED);
+				else
+					variable_type_pointer->variable_type = token_type;
+				get_next_token();
+
+				/* link parameter name with argument already on
+				   local var stack */
+				variable_type_pointer->name_id = variable_id(current_token);
+				get_next_token();
+				position--;
+			}
+			else
+				break;
+		} while (*current_token == ',');
+		if (*current_token != ')')
+			syntax_error(PAREN_EXPECTED);
+	}
+	/**
+	 * Interpret a single statement or block of code.
+	 * When interpret_block() returns from its initial call,
+	 * the final brace (or a return) in main() has been encountered.
+	 */
+	void interpret_block()
+	{
+		int value;
+		char block = 0;
+
+		do
+		{
+			/* строки-значения прошлой инструкции больше никому не нужны */
+			if (!temp_strings.empty())
+				release_temp_strings(function_last_index_on_call_stack);
+			token_type = get_next_token();
+
+			/* If interpreting single statement, return on
+			   first semicolon.
+			*/
+
+			/* see what kind of current_token is up */
+			if (token_type == VARIABLE)
+			{
+				/* Not a keyword, so process expression. */
+				shift_source_code_location_back(); /* restore current_token to input stream for
+						  further processing by eval_exp() */
+				eval_expression(&value);		   /* process the expression */
+				if (*current_token != ';')
+					syntax_error(SEMICOLON_EXPECTED);
+			}
+			else if (token_type == BLOCK)
+			{							   /* if block delimiter */
+				if (*current_token == '{') /* is a block */
+					block = 1;			   /* interpreting block, not statement */
+				else
+					return; /* is a }, so return */
+			}
+			else /* is keyword */
+				switch (current_tok_datatype)
+				{
+					case CHAR:
+					case INT:
+					case LONG:
+					case STR: /* declare local variables */
+						shift_source_code_location_back();
+						declare_local_variables();
+						break;
+					case RETURN: /* return from function call */
+						function_return();
+						ret_occurring = 1;
+						return;
+					case CONTINUE: /* continue loop execution */
+						return;
+					case BREAK: /* break loop execution */
+						break_occurring = 1;
+						return;
+					case IF: /* process an if statement */
+						execute_if_statement();
+						if (ret_occurring > 0 || break_occurring > 0)
+						{
+							return;
+						}
+						break;
+					case ELSE:		/* process an else statement */
+						find_eob(); /* find end of else block and continue execution */
+						break;
+					case WHILE: /* process a while loop */
+						exec_while();
+						if (ret_occurring > 0)
+						{
+							return;
+						}
+						break;
+					case DO: /* process a do-while loop */
+						exec_do();
+						if (ret_occurring > 0)
+						{
+							return;
+						}
+						break;
+					case FOR: /* process a for loop */
+						exec_for();
+						if (ret_occurring > 0)
+						{
+							return;
+						}
+						break;
+					case PARFOR: /* итерации делятся между потоками пула */
+						exec_parfor();
+						break;
+					case YIELD: /* значение - в next(), тело ждет следующего next() */
+						exec_yield();
+						break;
+					case END: /* программа закончена, хост-процесс живет дальше */
+						longjmp(execution_buffer, RUN_ENDED);
+				}
+		} while (current_tok_datatype != FINISHED && block);
+	}
+	/**
+	 * Declare a local variable
+	 */
+	void declare_local_variables()
+	{
+		int variable_type, length;
+		char name[ID_LEN], *declared_at;
+
+		get_next_token(); /* get type */
+
+		variable_type = current_tok_datatype;
+
+		do
+		{					  /* process comma-separated list */
+			get_next_token(); /* get var name */
+			strcpy_s(name, ID_LEN, current_token);
+			declared_at = source_code_location;
+			get_next_token();
+			if (*current_token == '[')
+			{
+				length = read_array_length();
+				if (!length)
+					runtime_error(ARRAY_SIZE);
+				if (variable_type == STR)
+					runtime_error(SYNTAX); /* массивов строк нет */
+				local_push(name, ARRAY, local_array(variable_type, length, declared_at));
+			}
+			else if (variable_type == LONG)
+			{
+				local_push(name, LONG, local_array(LONG, 1, declared_at));
+				arrays[local_values[lvartos - 1]]->variable = true;
+			}
+			else if (variable_type == STR)
+				local_push(name, STR, local_array(STR, 0, declared_at));
+			else
+				local_push(name, variable_type, 0); /* init to 0 */
+		} while (*current_token == ',');
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+	}
+	/**
+	 * Return from a function
+	 */
+	void function_return()
+	{
+		compiled_expression *compiled;
+		expr_node *arg;
+
+		/* return f(...) - хвостовой вызов: считаем аргументы, а сам вызов сделает
+		   interpret_function_body() в кадре текущей функции. Если у кадра есть
+		   массивы, строки или генераторы, аргументы могут на них ссылаться - тогда вызов обычный */
+		compiled = compiled_expression_at(source_code_location);
+		if (compiled && compiled->code->op == OP_CALL && !compiled->code->value &&
+			(int)frame_arrays.size() == call_stack[function_last_index_on_call_stack - 1].arrays &&
+			(int)frame_generators.size() == call_stack[function_last_index_on_call_stack - 1].generators)
+		{
+			tail_call_count = 0;
+			for (arg = compiled->code->left; arg; arg = arg->next)
+				tail_call_args[tail_call_count++] = eval_node(arg);
+			tail_call = compiled->code;
+			skip_compiled_expression(compiled);
+			return;
+		}
+
+		wide_result = 0;
+		/* get return value, if any */
+		eval_wide_expression(&wide_result);
+
+		ret_value = (int)wide_result;
+		if (string_functions && call_stack[function_last_index_on_call_stack - 1].returns_string)
+			ret_value = return_string(ret_value);
+		else if ((int)frame_generators.size() > call_stack[function_last_index_on_call_stack - 1].generators)
+			return_generator(ret_value);
+	}
+	/* Execute an if statement. */
+	void execute_if_statement()
+	{
+		int condition;
+		long offset = source_code_location - program_start_buffer;
+		bool first_time = offset >= 0 && offset < program_size && !expression_cache[offset];
+
+		eval_expression(&condition); /* get if expression */
+
+		/* условие свернулось в константу - одна из веток мертвая и больше не разбирается */
+		if (dump_optimizations && first_time && expression_cache[offset]->root &&
+			expression_cache[offset]->root->op == OP_CONST)
+			std::cout << "[opt] строка " << line_of(program_start_buffer + offset) << ": if ("
+				 << condition << ") - " << (condition ? "ветка else удалена" : "ветка if удалена") << std::endl;
+
+		if (condition)
+		{ /* is true so process target of IF */
+			interpret_block();
+		}
+		else
+		{				/* otherwise skip around IF block and
+					process the ELSE, if present */
+			find_eob(); /* find start of next line */
+			get_next_token();
+
+			if (current_tok_datatype != ELSE)
+			{
+				shift_source_code_location_back(); /* restore current_token if
+						  no ELSE is present */
+				return;
+			}
+			interpret_block();
+		}
+	}
+	/* Find the end of a block. */
+	void find_eob()
+	{
+		int brace;
+		long offset = source_code_location - program_start_buffer;
+
+		/* блок уже пропускали - прыгаем сразу за его } */
+		if (offset >= 0 && offset < program_size && block_end_cache[offset])
+		{
+			source_code_location = block_end_cache[offset];
+			strcpy_s(current_token, 80, "}");
+			token_type = BLOCK;
+			current_tok_datatype = 0;
+			return;
+		}
+
+		get_next_token();
+		brace = 1;
+		do
+		{
+			get_next_token();
+			if (*current_token == '{')
+				brace++;
+			else if (*current_token == '}')
+				brace--;
+		} while (brace);
+
+		if (offset >= 0 && offset < program_size)
+			block_end_cache[offset] = source_code_location;
+	}
+	/* Execute a while loop. */
+	void exec_while()
+	{
+		int cond;
+		char *temp;
+
+		break_occurring = 0; /* clear the break flag */
+		shift_source_code_location_back();
+		temp = source_code_location; /* save location of top of while loop */
+		get_next_token();
+		eval_expression(&cond); /* check the conditional expression */
+		if (cond)
+		{
+			interpret_block(); /* if true, interpret */
+			if (break_occurring > 0)
+			{
+				break_occurring = 0;
+				return;
+			}
+		}
+		else
+		{ /* otherwise, skip around loop */
+			find_eob();
+			return;
+		}
+		count_step();
+		source_code_location = temp; /* loop back to top */
+	}
+	/* Execute a do loop. */
+	void exec_do()
+	{
+		int cond;
+		char *temp;
+
+		shift_source_code_location_back();
+		temp = source_code_location; /* save location of top of do loop */
+		break_occurring = 0;		 /* clear the break flag */
+
+		get_next_token();  /* get start of loop */
+		interpret_block(); /* interpret loop */
+		if (ret_occurring > 0)
+		{
+			return;
+		}
+		else if (break_occurring > 0)
+		{
+			break_occurring = 0;
+			return;
+		}
+		get_next_token();
+		if (current_tok_datatype != WHILE)
+			syntax_error(WHILE_EXPECTED);
+		eval_expression(&cond); /* check the loop condition */
+		if (cond)
+		{
+			count_step();
+			source_code_location = temp; /* if true loop; otherwise,
+					   continue on */
+		}
+	}
+	/* Execute a for loop. */
+	void exec_for()
+	{
+		int cond;
+		char *init, *temp, *temp2;
+		compiled_for *loop;
+
+		break_occurring = 0; /* clear the break flag */
+		get_next_token();
+		init = source_code_location;
+		eval_expression(&cond); /* initialization expression */
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+		source_code_location++; /* get past the ; */
+		temp = source_code_location;
+		eval_expression(&cond); /* check the condition */
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+		source_code_location++; /* get past the ; */
+		temp2 = source_code_location;
+		loop = compiled_for_at(init, temp, temp2);
+		if (cond && loop->kernel && run_loop_kernel(loop->kernel))
+		{
+			source_code_location = loop->kernel->end;
+			return;
+		}
+		for (;;)
+		{
+			source_code_location = loop->body;
+			if (cond)
+			{
+				interpret_block(); /* if true, interpret */
+				if (ret_occurring > 0)
+				{
+					return;
+				}
+				else if (break_occurring > 0)
+				{
+					break_occurring = 0;
+					return;
+				}
+			}
+			else
+			{ /* otherwise, skip around loop */
+				find_eob();
+				return;
+			}
+			count_step();
+			if (loop->step_and_test)
+			{ /* шаг и условие одной суперинструкцией */
+				cond = eval_node(loop->step_and_test);
+				continue;
+			}
+			source_code_location = temp2;
+			eval_expression(&cond);		 /* do the increment */
+			source_code_location = temp; /* loop back to top */
+			eval_expression(&cond); /* check the condition */
+			if (*current_token != ';')
+				syntax_error(SEMICOLON_EXPECTED);
+		}
+	}
+	/**
+	 * Заголовок цикла for, у которого условие начинается в condition, а шаг в step.
+	 * В первый раз ищем начало тела, пробуем слить шаг с условием и узнать
+	 * границы переменной цикла (prove_index_range())
+	 * @param init
+	 * @param condition
+	 * @param step
+	 * @return
+	 */
+	compiled_for *compiled_for_at(char *init, char *condition, char *step)
+	{
+		long offset = step - program_start_buffer;
+		compiled_for *loop;
+		compiled_expression *step_code, *condition_code;
+		int brace;
+
+		if (offset >= 0 && offset < program_size && for_cache[offset])
+			return for_cache[offset];
+
+		/* find the start of the for block */
+		source_code_location = step;
+		brace = 1;
+		while (brace)
+		{
+			get_next_token();
+			if (*current_token == '(')
+				brace++;
+			if (*current_token == ')')
+				brace--;
+		}
+
+		loop = memory.make<compiled_for>();
+		loop->body = source_code_location;
+		loop->step_and_test = nullptr;
+		loop->kernel = nullptr;
+		step_code = compiled_expression_at(step);
+		condition_code = compiled_expression_at(condition);
+		if (step_code && condition_code && !op_stats &&
+			step_code->code->op == OP_ADD_TO_VAR &&
+			(condition_code->code->op == OP_COMPARE_VAR_CONST || condition_code->code->op == OP_COMPARE_VAR_VAR) &&
+			!strcmp(step_code->code->name, condition_code->code->name))
+			loop->step_and_test = new_node(OP_STEP_AND_TEST, step_code->code, condition_code->code);
+		prove_index_range(compiled_expression_at(init), condition_code, step_code, loop->body);
+		if (!op_stats)
+			loop->kernel = vectorize_loop(condition_code, step_code, loop->body);
+
+		if (offset >= 0 && offset < program_size)
+			for_cache[offset] = loop;
+		return loop;
+	}
+	/**
+	 * for (i = C1; i < C2; i = i + S) { ... } с локальной i, C1 >= 0, S > 0 и
+	 * без присваиваний i в теле: внутри тела C1 <= i < C2. Такие диапазоны
+	 * снимают проверку границ с a[i] (см. prove_index())
+	 */
+	void prove_index_range(compiled_expression *init, compiled_expression *condition, compiled_expression *step, char *body)
+	{
+		expr_node *start, *bound, *increment;
+		index_range range{};
+		int *slot, brace = 0;
+
+		if (!init || !condition || !step)
+			return;
+		start = init->root;
+		bound = condition->root;
+		increment = step->root;
+		if (start->op != OP_ASSIGN || start->right->op != OP_CONST || start->right->value < 0)
+			return;
+		range.name_id = start->name_id;
+		if ((bound->op != OP_LOWER && bound->op != OP_LOWER_OR_EQUAL) || bound->left->op != OP_VAR ||
+			bound->left->name_id != range.name_id || bound->right->op != OP_CONST)
+			return;
+		if (increment->op != OP_ASSIGN || increment->name_id != range.name_id || increment->right->op != OP_ADD ||
+			increment->right->left->op != OP_VAR || increment->right->left->name_id != range.name_id ||
+			increment->right->right->op != OP_CONST || increment->right->right->value <= 0)
+			return;
+		range.low = start->right->value;
+		range.high = bound->op == OP_LOWER ? bound->right->value - 1 : bound->right->value;
+		/* после последнего шага i не должна переполниться и снова пройти условие */
+		if (range.high < range.low || (long)range.high + increment->right->right->value > INT_MAX)
+			return;
+		/* глобальную переменную может изменить вызванная функция */
+		slot = lookup_var(range.name_id);
+		if (!slot || slot < local_values.data() + frame_base() || slot >= local_values.data() + lvartos)
+			return;
+
+		source_code_location = body;
+		range.from = body;
+		do
+		{
+			get_next_token();
+			if (token_type == BLOCK)
+				brace += *current_token == '{' ? 1 : -1;
+			else if (current_tok_datatype == FINISHED || (!brace && *current_token == ';'))
+				return; /* тело без фигурных скобок не разбираем */
+			else if (token_type == VARIABLE && known_variable_id(current_token) == range.name_id)
+			{
+				get_next_token();
+				if (*current_token == '=')
+					return;
+				shift_source_code_location_back();
+			}
+		} while (brace);
+		range.to = source_code_location;
+		index_ranges.push_back(range);
+	}
+	/**
+	 * Имя где-то в разбираемой функции объявлено массивом. Присваивание такому
+	 * имени не компилируем - его проверяет assign_var()
+	 */
+	bool declared_array(int name_id)
+	{
+		int function = function_index_at(source_code_location);
+
+		if (function < 0)
+			return is_array_variable(name_id);
+		for (auto &bound : function_table[function].arrays)
+			if (bound.name_id == name_id)
+				return true;
+		return false;
+	}
+	/**
+	 * Что имя означает в разбираемой функции
+	 * @return LONG - переменная long, ARRAY - массив long, -1 - long только в части функции, 0 - другое
+	 */
+	int long_kind(int name_id)
+	{
+		int function = function_index_at(source_code_location);
+		int type;
+
+		if (function < 0)
+		{
+			type = variable_type_of(name_id);
+			if (type == ARRAY)
+				return arrays[*find_var_slot(name_id)]->type == LONG ? ARRAY : 0;
+			return type == LONG ? LONG : 0;
+		}
+		function_type &f = function_table[function];
+		if (std::find(f.unsure_names.begin(), f.unsure_names.end(), name_id) != f.unsure_names.end())
+			return -1;
+		if (std::find(f.long_names.begin(), f.long_names.end(), name_id) != f.long_names.end())
+			return LONG;
+		if (std::find(f.long_arrays.begin(), f.long_arrays.end(), name_id) != f.long_arrays.end())
+			return ARRAY;
+		return 0;
+	}
+	/**
+	 * @return STR - переменная string, -1 - string только в части функции, 0 - другое
+	 */
+	int string_kind(int name_id)
+	{
+		int function = function_index_at(source_code_location);
+
+		if (function < 0)
+			return variable_type_of(name_id) == STR ? STR : 0;
+		function_type &f = function_table[function];
+		if (std::find(f.mixed_string_names.begin(), f.mixed_string_names.end(), name_id) != f.mixed_string_names.end())
+			return -1;
+		if (std::find(f.string_names.begin(), f.string_names.end(), name_id) != f.string_names.end())
+			return STR;
+		return 0;
+	}
+	/**
+	 * name = выражение для переменной string, current_token - =.
+	 * name = concat(name, x) дописывает x на месте, без копии всей строки
+	 */
+	expr_node *compile_string_assignment(const char *name)
+	{
+		expr_node *node, *value, *first;
+
+		get_next_token();
+		value = compile_assignment_expression();
+		if (!value)
+			return nullptr;
+		node = new_node(OP_STRING_ASSIGN, nullptr, value);
+		strcpy_s(node->name, ID_LEN, name);
+		node->name_id = variable_id(name);
+		first = value->left;
+		if (value->op == OP_NATIVE && !strcmp(value->name, "concat") && first->op == OP_VAR &&
+			first->name_id == node->name_id)
+		{
+			node->op = OP_STRING_APPEND;
+			node->right = first->next;
+		}
+		return node;
+	}
+	/**
+	 * Переменная в дереве выражения: OP_VAR или OP_GLOBAL
+	 */
+	static bool is_variable_node(expr_node *node)
+	{
+		return node && (node->op == OP_VAR || node->op == OP_GLOBAL);
+	}
+	static bool same_variable(expr_node *node, expr_node *variable)
+	{
+		return is_variable_node(node) && node->name_id == variable->name_id;
+	}
+	/**
+	 * Массив из node = массив[counter]
+	 * @return nullptr, если node не такой
+	 */
+	static expr_node *element_at_counter(expr_node *node, expr_node *counter)
+	{
+		if ((node->op != OP_INDEX && node->op != OP_INDEX_UNCHECKED) || !is_variable_node(node->left) ||
+			!same_variable(node->right, counter) || same_variable(node->left, counter))
+			return nullptr;
+		return node->left;
+	}
+	/**
+	 * Следующая инструкция тела цикла как скомпилированное выражение, за
+	 * которым стоит ;
+	 */
+	compiled_expression *body_statement()
+	{
+		compiled_expression *statement;
+
+		get_next_token();
+		if (token_type != VARIABLE)
+			return nullptr;
+		statement = compiled_expression_at(source_code_location - strlen(current_token));
+		if (!statement || *statement->terminator != ';')
+			return nullptr;
+		source_code_location = statement->end + 1;
+		return statement;
+	}
+	/**
+	 * Узнать в цикле for с шагом i = i + 1 и телом из одной инструкции
+	 * сумму t = t + a[i], подсчет if (a[i] < k) { c = c + 1; } или
+	 * сложение c[i] = a[i] + b[i]. Такой цикл run_loop_kernel() выполняет
+	 * векторным ядром; проверить типы и границы массивов можно только при
+	 * выполнении, поэтому обычный путь остается.
+	 * @return nullptr, если цикл не такой
+	 */
+	loop_kernel *vectorize_loop(compiled_expression *condition, compiled_expression *step, char *body)
+	{
+		static const char *kind_names[] = {"сумма", "подсчет", "сложение массивов"};
+		loop_kernel kernel{};
+		compiled_expression *statement;
+		expr_node *node, *increment;
+
+		if (!condition || !step)
+			return nullptr;
+		node = condition->root;
+		if ((node->op != OP_LOWER && node->op != OP_LOWER_OR_EQUAL) || !is_variable_node(node->left) ||
+			(node->right->op != OP_CONST && !is_variable_node(node->right)) || same_variable(node->right, node->left))
+			return nullptr;
+		kernel.counter = node->left;
+		kernel.bound = node->right;
+		kernel.inclusive = node->op == OP_LOWER_OR_EQUAL;
+		increment = step->root;
+		if (increment->op != OP_ASSIGN || increment->name_id != kernel.counter->name_id || increment->right->op != OP_ADD ||
+			!same_variable(increment->right->left, kernel.counter) || increment->right->right->op != OP_CONST ||
+			increment->right->right->value != 1)
+			return nullptr;
+
+		source_code_location = body;
+		get_next_token();
+		if (*current_token != '{')
+			return nullptr;
+		get_next_token();
+		if (token_type == KEYWORD && current_tok_datatype == IF)
+		{
+			statement = compiled_expression_at(source_code_location);
+			if (!statement)
+				return nullptr;
+			node = statement->root;
+			if (node->op < OP_LOWER || node->op > OP_NOT_EQUAL)
+				return nullptr;
+			kernel.kind = KERNEL_COUNT;
+			kernel.compare = node->op;
+			kernel.first = element_at_counter(node->left, kernel.counter);
+			kernel.limit = node->right;
+			if (!kernel.first)
+			{ /* k < a[i] - то же, что a[i] > k */
+				static const int swapped[] = {OP_GREATER, OP_GREATER_OR_EQUAL, OP_LOWER, OP_LOWER_OR_EQUAL, OP_EQUAL, OP_NOT_EQUAL};
+
+				kernel.first = element_at_counter(node->right, kernel.counter);
+				kernel.limit = node->left;
+				kernel.compare = swapped[node->op - OP_LOWER];
+			}
+			if (!kernel.first || (kernel.limit->op != OP_CONST && !is_variable_node(kernel.limit)) ||
+				same_variable(kernel.limit, kernel.counter))
+				return nullptr;
+			skip_compiled_expression(statement);
+			get_next_token();
+			if (*current_token != '{')
+				return nullptr;
+			statement = body_statement();
+			if (!statement)
+				return nullptr;
+			node = statement->root;
+			if (node->op != OP_ASSIGN || node->right->op != OP_ADD || !is_variable_node(node->right->left) ||
+				node->right->left->name_id != node->name_id || node->right->right->op != OP_CONST ||
+				node->right->right->value != 1)
+				return nullptr;
+			kernel.target = node->right->left;
+			get_next_token();
+			if (*current_token != '}' || same_variable(kernel.limit, kernel.target))
+				return nullptr;
+			get_next_token();
+			if (token_type == KEYWORD && current_tok_datatype == ELSE)
+				return nullptr;
+			shift_source_code_location_back();
+		}
+		else
+		{
+			shift_source_code_location_back();
+			statement = body_statement();
+			if (!statement)
+				return nullptr;
+			node = statement->root;
+			if (node->op == OP_ASSIGN && node->right->op == OP_ADD)
+			{
+				kernel.kind = KERNEL_SUM;
+				kernel.target = node->right->left;
+				kernel.first = element_at_counter(node->right->right, kernel.counter);
+				if (!kernel.first)
+				{
+					kernel.target = node->right->right;
+					kernel.first = element_at_counter(node->right->left, kernel.counter);
+				}
+				if (!kernel.first || !is_variable_node(kernel.target) || kernel.target->name_id != node->name_id)
+					return nullptr;
+			}
+			else if ((node->op == OP_STORE || node->op == OP_STORE_UNCHECKED) && same_variable(node->left, kernel.counter) &&
+					 node->right->op == OP_ADD)
+			{
+				kernel.kind = KERNEL_ADD;
+				kernel.target = new_node(OP_VAR);
+				kernel.target->name_id = node->name_id;
+				kernel.first = element_at_counter(node->right->left, kernel.counter);
+				kernel.second = element_at_counter(node->right->right, kernel.counter);
+				if (!kernel.first || !kernel.second)
+					return nullptr;
+			}
+			else
+				return nullptr;
+		}
+		get_next_token();
+		if (*current_token != '}')
+			return nullptr;
+		kernel.end = source_code_location;
+		/* тело не должно менять ни i, ни границу цикла, ни массив */
+		if (same_variable(kernel.target, kernel.counter) || same_variable(kernel.bound, kernel.target) ||
+			(kernel.kind != KERNEL_ADD && same_variable(kernel.first, kernel.target)))
+			return nullptr;
+
+		if (dump_optimizations)
+			std::cout << "[opt] строка " << line_of(body) << ": цикл for - " << kind_names[kernel.kind] << ", ядро "
+				 << array_kernels::selected().name << std::endl;
+		return memory.make<loop_kernel>(kernel);
+	}
+	/**
+	 * Значение переменной из дерева выражения или константы
+	 */
+	int *variable_slot(expr_node *node)
+	{
+		return node->op == OP_GLOBAL ? &global_values[node->value] : find_var_slot(node->name_id);
+	}
+	/**
+	 * Массив int для ядра, в котором есть элементы до end
+	 * @return nullptr - пусть цикл выполнится как обычно и сам найдет ошибку
+	 */
+	array_data *kernel_array(expr_node *node, long end)
+	{
+		int handle = *variable_slot(node);
+
+		if (handle <= 0 || handle >= (int)arrays.size() || !arrays[handle] || arrays[handle]->type != INT ||
+			arrays[handle]->length < end)
+			return nullptr;
+		return arrays[handle].get();
+	}
+	/**
+	 * Выполнить цикл из vectorize_loop() одним вызовом ядра. Условие цикла
+	 * уже истинно, i - начальное значение
+	 * @return false, если ядро здесь не подходит и цикл надо выполнить обычным путем
+	 */
+	bool run_loop_kernel(loop_kernel *kernel)
+	{
+		const array_kernels &simd = kernels();
+		int *counter = variable_slot(kernel->counter), *target;
+		long start = *counter;
+		long stop = (kernel->bound->op == OP_CONST ? kernel->bound->value : *variable_slot(kernel->bound)) +
+					(kernel->inclusive ? 1 : 0);
+		array_data *first, *second, *result;
+		int count, limit, found = 0;
+
+		if (start < 0 || start >= stop || stop > INT_MAX)
+			return false;
+		count = (int)(stop - start);
+		first = kernel_array(kernel->first, stop);
+		if (!first)
+			return false;
+		switch (kernel->kind)
+		{
+			case KERNEL_SUM:
+				target = variable_slot(kernel->target);
+				*target = (int)((uint32_t)*target + (uint32_t)simd.sum(first->ints + start, count));
+				break;
+			case KERNEL_COUNT:
+				target = variable_slot(kernel->target);
+				limit = kernel->limit->op == OP_CONST ? kernel->limit->value : *variable_slot(kernel->limit);
+				switch (kernel->compare)
+				{
+					case OP_LOWER:
+						found = simd.count_less(first->ints + start, count, limit);
+						break;
+					case OP_LOWER_OR_EQUAL:
+						found = count - simd.count_greater(first->ints + start, count, limit);
+						break;
+					case OP_GREATER:
+						found = simd.count_greater(first->ints + start, count, limit);
+						break;
+					case OP_GREATER_OR_EQUAL:
+						found = count - simd.count_less(first->ints + start, count, limit);
+						break;
+					case OP_EQUAL:
+						found = simd.count_equal(first->ints + start, count, limit);
+						break;
+					case OP_NOT_EQUAL:
+						found = count - simd.count_equal(first->ints + start, count, limit);
+						break;
+				}
+				*target = (int)((uint32_t)*target + (uint32_t)found);
+				break;
+			case KERNEL_ADD:
+				second = kernel_array(kernel->second, stop);
+				result = kernel_array(kernel->target, stop);
+				if (!second || !result)
+					return false;
+				simd.add(result->ints + start, first->ints + start, second->ints + start, count);
+				break;
+		}
+		*counter = (int)stop;
+		steps_left -= count;
+		if (steps_left < 0)
+			step_budget_exhausted();
+		return true;
+	}
+	/**
+	 * Длина массива, если она известна в этом месте без выполнения
+	 * @param array описатель из OP_VAR или OP_GLOBAL
+	 * @return 0, если неизвестна
+	 */
+	int static_array_length(expr_node *array)
+	{
+		if (array->op == OP_GLOBAL)
+			return global_lengths[array->value];
+		if (array->op != OP_VAR || optimizing_function < 0)
+			return 0;
+		for (auto &bound : function_table[optimizing_function].arrays)
+			if (bound.name_id == array->name_id && array->source > bound.valid_from)
+				return bound.length;
+		return 0;
+	}
+	/**
+	 * Границы значения индекса: константа, переменная цикла из index_ranges
+	 * или они же плюс-минус константа
+	 * @return false, если границы неизвестны
+	 */
+	bool index_bounds(expr_node *index, long &low, long &high)
+	{
+		switch (index->op)
+		{
+			case OP_CONST:
+				low = high = index->value;
+				return true;
+			case OP_VAR:
+				for (auto &range : index_ranges)
+					if (range.name_id == index->name_id && index->source > range.from && index->source < range.to)
+					{
+						low = range.low;
+						high = range.high;
+						return true;
+					}
+				return false;
+			case OP_ADD:
+			case OP_SUB:
+				if (index->right->op != OP_CONST || !index_bounds(index->left, low, high))
+					return false;
+				low += index->op == OP_ADD ? index->right->value : -index->right->value;
+				high += index->op == OP_ADD ? index->right->value : -index->right->value;
+				return true;
+			default:
+				return false;
+		}
+	}
+	/**
+	 * Снять проверку границ с a[индекс] (OP_INDEX или OP_STORE), если индекс
+	 * доказанно внутри массива известной длины
+	 */
+	expr_node *prove_index(expr_node *node, expr_node *array)
+	{
+		expr_node *index = node->op == OP_INDEX ? node->right : node->left;
+		int length = static_array_length(array);
+		long low, high;
+
+		if (!length || !index_bounds(index, low, high) || low < 0 || high >= length)
+			return node;
+		node->op = node->op == OP_INDEX ? OP_INDEX_UNCHECKED : OP_STORE_UNCHECKED;
+		if (dump_optimizations)
+			std::cout << "[opt] строка " << line_of(array->source) << ": " << variable_names[array->name_id]
+				 << "[] - индекс в [" << low << ", " << high << "], проверка границ снята" << std::endl;
+		return node;
+	}
+	/**
+	 * [N] в объявлении массива, current_token - [. Останавливается за ]
+	 * @return N или 0, если это не положительная константа до max_array_size
+	 */
+	int read_array_length()
+	{
+		long length = 0;
+
+		get_next_token();
+		if (token_type == NUMBER)
+		{
+			length = atol(current_token);
+			get_next_token();
+		}
+		if (*current_token != ']' || length <= 0 || length > max_array_size)
+			length = 0;
+		else
+			get_next_token();
+		return (int)length;
+	}
+	int new_array(int type, int length)
+	{
+		int handle;
+
+		if (free_arrays.empty())
+		{
+			arrays.emplace_back();
+			handle = (int)arrays.size() - 1;
+		}
+		else
+		{
+			handle = free_arrays.back();
+			free_arrays.pop_back();
+		}
+		arrays[handle] = std::make_shared<array_data>(type, length);
+		return handle;
+	}
+	/**
+	 * Массив локального объявления. Объявление в цикле выполняется много раз -
+	 * тогда кадр получает обнуленный массив прошлой итерации, а не новый
+	 */
+	int local_array(int type, int length, char *declared_at)
+	{
+		int handle;
+
+		for (size_t i = function_last_index_on_call_stack ? call_stack[function_last_index_on_call_stack - 1].arrays : 0;
+			 i < frame_arrays.size(); i++)
+			if (frame_arrays[i].declared_at == declared_at)
+			{
+				array_data &reused = *arrays[frame_arrays[i].handle];
+
+				if (reused.type == STR)
+					reused.assign("", 0);
+				else if (sharing_tasks)
+					for (int k = 0; k < reused.length; k++)
+						reused.set(k, 0);
+				else
+					memset(reused.ints, 0, (size_t)reused.length * reused.element_size());
+				return frame_arrays[i].handle;
+			}
+		handle = new_array(type, length);
+		frame_arrays.push_back({handle, declared_at});
+		return handle;
+	}
+	/**
+	 * Освободить массивы кадров с номера first в frame_arrays
+	 */
+	void release_frame_arrays(int first)
+	{
+		while ((int)frame_arrays.size() > first)
+		{
+			arrays[frame_arrays.back().handle].reset();
+			free_arrays.push_back(frame_arrays.back().handle);
+			frame_arrays.pop_back();
+		}
+	}
+	/**
+	 * Обнулить глобальные переменные и создать заново их массивы
+	 */
+	void clear_globals()
+	{
+		std::fill(global_values, global_values + global_variable_position, 0);
+		make_global_arrays();
+	}
+	void make_global_arrays()
+	{
+		arrays.assign(1, nullptr);
+		free_arrays.clear();
+		frame_arrays.clear();
+		temp_strings.clear();
+		for (int i = 0; i < global_variable_position; i++)
+			if (global_lengths[i])
+				global_values[i] = new_array(global_vars[i].variable_type, global_lengths[i]);
+			else if (global_vars[i].variable_type == LONG) /* ячейка - массив из одного элемента */
+			{
+				global_values[i] = new_array(LONG, 1);
+				arrays[global_values[i]]->variable = true;
+			}
+			else if (global_vars[i].variable_type == STR)
+				global_values[i] = new_array(STR, 0);
+		globals_ready = true;
+	}
+	array_data *array_at(int handle)
+	{
+		if (handle <= 0 || handle >= (int)arrays.size() || !arrays[handle])
+			runtime_error(NOT_ARRAY);
+		return arrays[handle].get();
+	}
+	int element(int handle, int index)
+	{
+		array_data *source = array_at(handle);
+
+		if ((unsigned)index >= (unsigned)source->length)
+			runtime_error(INDEX_RANGE);
+		return source->get(index);
+	}
+	int store_element(int handle, int index, int value)
+	{
+		array_data *target = array_at(handle);
+
+		if ((unsigned)index >= (unsigned)target->length)
+			runtime_error(INDEX_RANGE);
+		target->set(index, value);
+		return value;
+	}
+	/**
+	 * Переменная name_id - массив (ему самому присваивать нельзя)
+	 */
+	bool is_array_variable(int name_id)
+	{
+		return variable_type_of(name_id) == ARRAY;
+	}
+	/**
+	 * Тип переменной, которую сейчас означает имя: INT, CHAR, LONG или ARRAY
+	 * @return -1, если такой переменной нет
+	 */
+	int variable_type_of(int name_id)
+	{
+		int i;
+
+		for (i = lvartos - 1; i >= frame_base(); i--)
+			if (local_var_stack[i].name_id == name_id)
+				return local_var_stack[i].variable_type;
+		for (i = 0; i < global_variable_position; i++)
+			if (global_vars[i].name_id == name_id)
+				return global_lengths[i] ? ARRAY : global_vars[i].variable_type;
+		return -1;
+	}
+	/**
+	 * Ячейка переменной long
+	 * @return nullptr, если имя означает не long
+	 */
+	long long *long_cell(int name_id)
+	{
+		if (variable_type_of(name_id) != LONG)
+			return nullptr;
+		return arrays[*find_var_slot(name_id)]->longs;
+	}
+	/**
+	 * Элементы глобального массива int программы - их можно заполнить перед
+	 * call() и прочитать после
+	 * @param name
+	 * @param length сюда пишется длина массива
+	 * @return nullptr, если такого массива int нет
+	 */
+	int *global_array(const std::string &name, int *length = nullptr)
+	{
+		int *handle = global(name);
+
+		if (!handle || *handle <= 0 || *handle >= (int)arrays.size() || !arrays[*handle] ||
+			arrays[*handle]->type != INT)
+			return nullptr;
+		if (length)
+			*length = arrays[*handle]->length;
+		return arrays[*handle]->ints;
+	}
+	/* Pop index into local variable stack. */
+	int func_pop(void)
+	{
+		int index = 0;
+		function_last_index_on_call_stack--;
+		if (function_last_index_on_call_stack < 0)
+		{
+			syntax_error(RET_NOCALL);
+		}
+		else
+		{
+			index = call_stack[function_last_index_on_call_stack].base;
+			release_frame_arrays(call_stack[function_last_index_on_call_stack].arrays);
+			release_frame_generators(call_stack[function_last_index_on_call_stack].generators);
+		}
+
+		return index;
+	}
+
+
+
+	/**
+	 * Номер строки исходного кода, в которой находится location
+	 * @param location
+	 * @return
+	 */
+	int line_of(const char *location)
+	{
+		int line = 1;
+		char *p;
+
+		for (p = program_start_buffer; p < location && *p; p++)
+			if (*p == '\n')
+				line++;
+		return line;
+	}
+	/**
+	 * Индекс функции, в теле которой находится location
+	 * @param location
+	 * @return -1 если место вне функций
+	 */
+	int function_index_at(const char *location)
+	{
+		int i;
+
+		for (i = 0; i < function_position; i++)
+			if (location >= function_table[i].loc && function_table[i].end && location < function_table[i].end)
+				return i;
+		return -1;
+	}
+	/**
+	 * Вернуть скомпилированное выражение, которое начинается в location.
+	 * В первый раз выражение разбирается в дерево и оптимизируется, дальше берется из кеша.
+	 * @param location
+	 * @return nullptr если выражение нельзя скомпилировать - тогда его считает обычный разбор
+	 */
+	compiled_expression *compiled_expression_at(char *location)
+	{
+		long offset = location - program_start_buffer;
+		compiled_expression *compiled;
+		char saved_token[80];
+		char saved_type, saved_datatype;
+		char *saved_location;
+		int function;
+		std::string before;
+
+		if (offset < 0 || offset >= program_size)
+			return nullptr;
+		if (expression_cache[offset])
+			return expression_cache[offset]->root ? expression_cache[offset] : nullptr;
+
+		/* константы функции нужны до разбора, чтобы анализ не вмешался в токенизатор посреди выражения */
+		function = function_index_at(location);
+		if (function >= 0 && !function_table[function].analyzed)
+			analyze_function_constants(function);
+
+		saved_location = source_code_location;
+		strcpy_s(saved_token, 80, current_token);
+		saved_type = token_type;
+		saved_datatype = current_tok_datatype;
+
+		source_code_location = location;
+		compiled = memory.make<compiled_expression>();
+		compiled->root = compile_expression();
+		compiled->end = source_code_location;
+		/* строку или конец файла после выражения не кешируем - их всегда разбирает токенизатор */
+		if (token_type == STRING || current_tok_datatype == FINISHED || strlen(current_token) >= ID_LEN)
+			compiled->root = nullptr;
+		else
+		{
+			strcpy_s(compiled->terminator, ID_LEN, current_token);
+			compiled->terminator_type = token_type;
+			compiled->terminator_datatype = current_tok_datatype;
+		}
+
+		if (compiled->root)
+		{
+			mark_wide(compiled->root);
+			compiled->root = widen_node(compiled->root, false);
+			if (dump_optimizations)
+				dump_node(compiled->root, before);
+			optimizing_function = function;
+			compiled->root = optimize_node(compiled->root);
+			optimizing_function = -1;
+			/* при подсчете пар выполняем дерево как есть, без суперинструкций */
+			compiled->code = op_stats ? compiled->root : fuse_node(clone_node(compiled->root, nullptr));
+			if (dump_optimizations)
+			{
+				std::string after;
+				dump_node(compiled->code, after);
+				std::cout << "[opt] строка " << line_of(location) << ": " << before << "  =>  " << after << std::endl;
+			}
+		}
+		expression_cache[offset] = compiled;
+
+		source_code_location = saved_location;
+		strcpy_s(current_token, 80, saved_token);
+		token_type = saved_type;
+		current_tok_datatype = saved_datatype;
+		return compiled->root ? compiled : nullptr;
+	}
+	/**
+	 * Поставить токенизатор за скомпилированное выражение, как после eval_expression()
+	 * @param compiled
+	 */
+	void skip_compiled_expression(compiled_expression *compiled)
+	{
+		source_code_location = compiled->end;
+		strcpy_s(current_token, 80, compiled->terminator);
+		token_type = compiled->terminator_type;
+		current_tok_datatype = compiled->terminator_datatype;
+	}
+	/**
+	 * Отметить узлы, значение которых 64-битное: арифметика, где хоть один
+	 * операнд long. Листья и вызовы отмечены при разборе. Тип операции, как
+	 * в C, зависит только от операндов: в x + i * i (x long, i int) умножение
+	 * int и переполняется в 32 битах, а в long расширяется уже его результат
+	 */
+	static void mark_wide(expr_node *node)
+	{
+		expr_node *arg;
+
+		if (node->op == OP_CALL || node->op == OP_NATIVE)
+		{
+			for (arg = node->left; arg; arg = arg->next)
+				mark_wide(arg);
+			return;
+		}
+		if (node->left)
+			mark_wide(node->left);
+		if (node->right)
+			mark_wide(node->right);
+		if (node->other)
+			mark_wide(node->other);
+		if (node->op >= OP_NEG && node->op <= OP_MOD)
+			node->wide = node->left->wide || (node->right && node->right->wide);
+	}
+	/**
+	 * Узел считается через eval_wide(): 64-битное значение или сравнение 64-битных
+	 */
+	static bool wide_evaluated(expr_node *node)
+	{
+		if (node->wide)
+			return true;
+		if (node->op >= OP_LOWER && node->op <= OP_NOT_EQUAL)
+			return wide_evaluated(node->left) || wide_evaluated(node->right);
+		return false;
+	}
+	/**
+	 * Там, где 64-битное значение нужно как int (аргумент, индекс, присваивание
+	 * int, корень выражения), поставить OP_WIDE. Оптимизатор и слияние узлов в
+	 * OP_WIDE не заходят, поэтому свертка в int не трогает вычисления long.
+	 * В режиме checked_arithmetic сложение, вычитание, умножение и минус int
+	 * становятся OP_CHECKED
+	 * @param node
+	 * @param wide_parent родитель сам считает узел через eval_wide()
+	 * @return узел или OP_WIDE над ним
+	 */
+	expr_node *widen_node(expr_node *node, bool wide_parent)
+	{
+		bool wide = wide_evaluated(node), wide_operands;
+		expr_node **link, *next;
+
+		if (node->op == OP_CALL || node->op == OP_NATIVE)
+		{ /* параметры функций только int */
+			for (link = &node->left; *link; link = &(*link)->next)
+			{
+				next = (*link)->next;
+				*link = widen_node(*link, false);
+				(*link)->next = next;
+			}
+		}
+		else
+		{
+			/* индекс массива всегда int, значение - как у элементов массива */
+			wide_operands = wide && node->op != OP_INDEX && node->op != OP_STORE;
+			if (node->left)
+				node->left = widen_node(node->left, wide_operands);
+			if (node->right)
+				node->right = widen_node(node->right, wide_operands || (node->op == OP_STORE && node->wide));
+			if (node->other)
+				node->other = widen_node(node->other, wide_operands);
+		}
+		if (checked_arithmetic && !node->wide && (node->op == OP_ADD || node->op == OP_SUB || node->op == OP_MUL || node->op == OP_NEG))
+		{
+			node->relop = node->op;
+			node->op = OP_CHECKED;
+		}
+		if (wide && !wide_parent)
+			return new_node(OP_WIDE, node);
+		return node;
+	}
+	/**
+	 * Создать узел дерева выражения
+	 */
+	expr_node *new_node(char op, expr_node *left = nullptr, expr_node *right = nullptr)
+	{
+		auto *node = memory.make<expr_node>();
+
+		node->op = op;
+		node->value = 0;
+		node->name[0] = '\0';
+		node->name_id = -1;
+		node->source = source_code_location;
+		node->loc = nullptr;
+		node->magic = 0;
+		node->shift = 0;
+		node->wide = false;
+		node->number = 0;
+		node->left = left;
+		node->right = right;
+		node->other = nullptr;
+		node->next = nullptr;
+		return node;
+	}
+	/**
+	 * Разбор выражения в дерево. Повторяет eval_expression(), но ничего не вычисляет
+	 * @return nullptr при любой ошибке разбора
+	 */
+	expr_node *compile_expression()
+	{
+		expr_node *node;
+
+		get_next_token();
+		if (!*current_token)
+			return nullptr;
+		if (*current_token == ';')
+			return new_node(OP_CONST); /* пустое выражение */
+		node = compile_assignment_expression();
+		shift_source_code_location_back();
+		return node;
+	}
+	/* Присваивание */
+	expr_node *compile_assignment_expression()
+	{
+		char temp[ID_LEN];
+		char temp_tok;
+		char *after_name;
+		expr_node *node, *index;
+		int kind;
+
+		if (token_type == VARIABLE && !find_function_in_function_table(current_token))
+		{
+			strcpy_s(temp, ID_LEN, current_token);
+			temp_tok = token_type;
+			after_name = source_code_location;
+			get_next_token();
+			if (*current_token == '=')
+			{
+				kind = long_kind(variable_id(temp));
+				if (declared_array(variable_id(temp)) || string_kind(variable_id(temp)) == -1)
+					return nullptr; /* ошибку или строку разберет assign_var() */
+				if (string_kind(variable_id(temp)) == STR)
+					return compile_string_assignment(temp);
+				get_next_token();
+				node = new_node(kind == LONG || kind == -1 ? OP_LONG_ASSIGN : OP_ASSIGN, nullptr, compile_assignment_expression());
+				if (!node->right)
+					return nullptr;
+				node->wide = node->op == OP_LONG_ASSIGN;
+				strcpy_s(node->name, ID_LEN, temp);
+				node->name_id = variable_id(temp);
+				return node;
+			}
+			if (*current_token == '[')
+			{
+				get_next_token();
+				index = compile_assignment_expression();
+				if (index && *current_token == ']')
+				{
+					get_next_token();
+					if (*current_token == '=')
+					{
+						get_next_token();
+						node = new_node(OP_STORE, index, compile_assignment_expression());
+						if (!node->right)
+							return nullptr;
+						kind = long_kind(variable_id(temp));
+						node->wide = kind == ARRAY || kind == -1;
+						node->source = after_name - strlen(temp);
+						strcpy_s(node->name, ID_LEN, temp);
+						node->name_id = variable_id(temp);
+						return node;
+					}
+				}
+				/* не запись в элемент - разбираем заново как выражение */
+				source_code_location = after_name;
+			}
+			else
+				shift_source_code_location_back();
+			strcpy_s(current_token, 80, temp);
+			token_type = temp_tok;
+		}
+		return compile_exp1();
+	}
+	/* Операторы сравнения */
+	expr_node *compile_exp1()
+	{
+		expr_node *left, *right;
+		char op;
+
+		left = compile_exp2();
+		op = *current_token;
+		if (!left || token_type != DELIMITER || op < LOWER || op > NOT_EQUAL)
+			return left;
+		get_next_token();
+		right = compile_exp2();
+		if (!right)
+			return nullptr;
+		return new_node((char)(OP_LOWER + op - LOWER), left, right);
+	}
+	/* Сложение и вычитание */
+	expr_node *compile_exp2()
+	{
+		expr_node *left, *right;
+		char op;
+
+		left = compile_exp3();
+		while (left && ((op = *current_token) == '+' || op == '-'))
+		{
+			get_next_token();
+			right = compile_exp3();
+			if (!right)
+				return nullptr;
+			left = new_node(op == '+' ? OP_ADD : OP_SUB, left, right);
+		}
+		return left;
+	}
+	/* Умножение, деление и остаток */
+	expr_node *compile_exp3()
+	{
+		expr_node *left, *right;
+		char op;
+
+		left = compile_exp4();
+		while (left && ((op = *current_token) == '*' || op == '/' || op == '%'))
+		{
+			get_next_token();
+			right = compile_exp4();
+			if (!right)
+				return nullptr;
+			left = new_node(op == '*' ? OP_MUL : op == '/' ? OP_DIV : OP_MOD, left, right);
+		}
+		return left;
+	}
+	/* Унарные + и - */
+	expr_node *compile_exp4()
+	{
+		char op = '\0';
+		expr_node *node;
+
+		if (*current_token == '+' || *current_token == '-')
+		{
+			op = *current_token;
+			get_next_token();
+		}
+		node = compile_exp5();
+		if (node && op == '-')
+			node = new_node(OP_NEG, node);
+		return node;
+	}
+	/* Выражение в скобках */
+	expr_node *compile_exp5()
+	{
+		expr_node *node;
+
+		if (*current_token != '(')
+			return compile_atom();
+		get_next_token();
+		node = compile_assignment_expression();
+		if (!node || *current_token != ')')
+			return nullptr;
+		get_next_token();
+		return node;
+	}
+	/* Число, символ, переменная или вызов функции */
+	expr_node *compile_atom()
+	{
+		expr_node *node;
+		int native, kind;
+
+		switch (token_type)
+		{
+			case VARIABLE:
+				/* print и puts сами разбирают свои аргументы - их выполняет atom() */
+				if (internal_func(current_token) != -1)
+					return nullptr;
+				if ((native = native_call(current_token)) != -1)
+					node = compile_native(native);
+				else if (find_function_in_function_table(current_token))
+					node = compile_call();
+				else
+				{
+					node = new_node(OP_VAR);
+					node->source = source_code_location - strlen(current_token);
+					strcpy_s(node->name, ID_LEN, current_token);
+					node->name_id = variable_id(current_token);
+					kind = long_kind(node->name_id);
+					if (kind == LONG || kind == -1)
+					{
+						node->op = OP_LONG_VAR;
+						node->wide = true;
+					}
+					get_next_token();
+					if (*current_token != '[')
+						return node;
+					get_next_token();
+					node = new_node(OP_INDEX, node, compile_assignment_expression());
+					node->wide = kind == ARRAY || kind == -1;
+					if (!node->right || *current_token != ']')
+						return nullptr;
+				}
+				if (node)
+					get_next_token();
+				return node;
+			case NUMBER:
+				node = new_node(OP_CONST);
+				node->number = strtoll(current_token, nullptr, 10);
+				node->value = (int)node->number;
+				node->wide = node->number != node->value; /* не влезает в int */
+				get_next_token();
+				return node;
+			case STRING:
+				node = new_node(OP_TEXT);
+				node->value = (int)strlen(current_token);
+				node->source = (char *)memory.allocate(node->value + 1, 1);
+				memcpy(node->source, current_token, node->value + 1);
+				get_next_token();
+				return node;
+			case DELIMITER:
+				if (*current_token != '\'')
+					return nullptr;
+				node = new_node(OP_CONST);
+				node->value = *source_code_location;
+				source_code_location++;
+				if (*source_code_location != '\'')
+					return nullptr;
+				source_code_location++;
+				get_next_token();
+				return node;
+			default:
+				return nullptr;
+		}
+	}
+	/* Вызов встроенной функции: аргументы как у пользовательской, их число проверяется здесь */
+	expr_node *compile_native(int native)
+	{
+		expr_node *node = compile_call(), *arg;
+		int count = 0;
+
+		if (!node)
+			return nullptr;
+		for (arg = node->left; arg; arg = arg->next)
+			count++;
+		if (count != natives[native].arity)
+			return nullptr; /* ошибку покажет call_native_function() */
+		node->op = OP_NATIVE;
+		node->value = native;
+		node->loc = nullptr;
+		return node;
+	}
+	/* Вызов функции со списком аргументов */
+	expr_node *compile_call()
+	{
+		expr_node *node, **last_arg;
+		int count = 0;
+
+		node = new_node(OP_CALL);
+		strcpy_s(node->name, ID_LEN, current_token);
+		node->loc = find_function_in_function_table(current_token);
+		node->value = is_generator(node->loc);
+		node->wide = !node->value && function_type_at(node->loc) == LONG;
+		last_arg = &node->left;
+
+		get_next_token();
+		if (*current_token != '(')
+			return nullptr;
+		get_next_token();
+		if (*current_token == ')')
+			return node;
+		for (;;)
+		{
+			if (++count > NUM_PARAMS)
+				return nullptr;
+			*last_arg = compile_assignment_expression();
+			if (!*last_arg)
+				return nullptr;
+			last_arg = &(*last_arg)->next;
+			if (*current_token == ')')
+				return node;
+			if (*current_token != ',')
+				return nullptr;
+			get_next_token();
+		}
+	}
+	/**
+	 * Вычислить скомпилированное выражение
+	 * @param node
+	 * @return
+	 */
+	int eval_node(expr_node *node)
+	{
+		int partial_value;
+		int *variable;
+
+		if (op_stats)
+			count_op_pairs(node);
+		switch (node->op)
+		{
+			case OP_CONST:
+				return node->value;
+			case OP_VAR:
+				return *find_var_slot(node->name_id);
+			case OP_ASSIGN:
+				partial_value = eval_node(node->right);
+				*find_var_slot(node->name_id) = partial_value;
+				return partial_value;
+			case OP_CALL:
+				return call_compiled_function(node);
+			case OP_NATIVE:
+				return call_native_node(node);
+			case OP_NEG:
+				return wrap_neg(eval_node(node->left));
+			case OP_ADD:
+				partial_value = eval_node(node->left);
+				return wrap_add(partial_value, eval_node(node->right));
+			case OP_SUB:
+				partial_value = eval_node(node->left);
+				return wrap_sub(partial_value, eval_node(node->right));
+			case OP_MUL:
+				partial_value = eval_node(node->left);
+				return wrap_mul(partial_value, eval_node(node->right));
+			case OP_DIV:
+			case OP_MOD:
+				partial_value = eval_node(node->left);
+				return divide(node->op, partial_value, eval_node(node->right));
+			case OP_LOWER:
+				return eval_node(node->left) < eval_node(node->right);
+			case OP_LOWER_OR_EQUAL:
+				return eval_node(node->left) <= eval_node(node->right);
+			case OP_GREATER:
+				return eval_node(node->left) > eval_node(node->right);
+			case OP_GREATER_OR_EQUAL:
+				return eval_node(node->left) >= eval_node(node->right);
+			case OP_EQUAL:
+				return eval_node(node->left) == eval_node(node->right);
+			case OP_NOT_EQUAL:
+				return eval_node(node->left) != eval_node(node->right);
+			case OP_SHIFT_LEFT:
+				return (int)((uint32_t)eval_node(node->left) << node->value);
+			case OP_DIV_POW2:
+				partial_value = eval_node(node->left);
+				/* отрицательное делимое сдвигаем с поправкой, чтобы округлить к нулю */
+				return (partial_value + ((partial_value >> 31) & ((1 << node->value) - 1))) >> node->value;
+			case OP_MOD_POW2:
+			{
+				int mask = (1 << node->value) - 1;
+				int bias;
+
+				partial_value = eval_node(node->left);
+				bias = (partial_value >> 31) & mask;
+				return ((partial_value + bias) & mask) - bias;
+			}
+			case OP_DIV_MAGIC:
+				return divide_by_magic(node, eval_node(node->left));
+			case OP_MOD_MAGIC:
+				partial_value = eval_node(node->left);
+				return wrap_sub(partial_value, wrap_mul(divide_by_magic(node, partial_value), node->value));
+			case OP_GLOBAL:
+				return global_values[node->value];
+			case OP_INDEX:
+				partial_value = eval_node(node->left);
+				return element(partial_value, eval_node(node->right));
+			case OP_INDEX_UNCHECKED:
+				partial_value = eval_node(node->left);
+				return arrays[partial_value]->get(eval_node(node->right));
+			case OP_STORE:
+				partial_value = eval_node(node->left);
+				return store_element(*find_var_slot(node->name_id), partial_value, eval_node(node->right));
+			case OP_STORE_UNCHECKED:
+				variable = find_var_slot(node->name_id);
+				partial_value = eval_node(node->left);
+				arrays[*variable]->set(partial_value, eval_node(node->right));
+				return arrays[*variable]->get(partial_value);
+			case OP_SELECT:
+				return eval_node(node->left) ? eval_node(node->right) : eval_node(node->other);
+			case OP_WIDE:
+				return (int)eval_wide(node->left);
+			case OP_LONG_VAR:
+			case OP_LONG_ASSIGN:
+				return (int)eval_wide(node);
+			case OP_CHECKED:
+				return checked(node);
+			case OP_TEXT:
+				return new_string(node->source, node->value);
+			case OP_STRING_ASSIGN:
+				partial_value = eval_node(node->right);
+				return copy_string(partial_value, *find_var_slot(node->name_id));
+			case OP_STRING_APPEND:
+			{
+				array_data *tail = string_at(eval_node(node->right));
+
+				variable = find_var_slot(node->name_id);
+				string_at(*variable)->append(tail->bytes, tail->length);
+				return *variable;
+			}
+			case OP_ADD_TO_VAR:
+				variable = find_var_slot(node->name_id);
+				return *variable = wrap_add(*variable, node->value);
+			case OP_ADD_VAR_TO_VAR:
+				partial_value = *find_var_slot(node->left->name_id);
+				variable = find_var_slot(node->name_id);
+				return *variable = wrap_add(*variable, partial_value);
+			case OP_COMPARE_VAR_CONST:
+				return compare(node->relop, *find_var_slot(node->name_id), node->value);
+			case OP_COMPARE_VAR_VAR:
+				return compare(node->relop, *find_var_slot(node->name_id), *find_var_slot(node->left->name_id));
+			case OP_STEP_AND_TEST:
+				variable = find_var_slot(node->left->name_id);
+				*variable = wrap_add(*variable, node->left->value);
+				partial_value = *variable;
+				return compare(node->right->relop, partial_value,
+							   node->right->op == OP_COMPARE_VAR_CONST ? node->right->value
+																	   : *find_var_slot(node->right->left->name_id));
+			default:
+				syntax_error(SYNTAX);
+				return 0;
+		}
+	}
+	/**
+	 * Значение узла в 64 битах. Узлы int считает eval_node(), в том числе
+	 * арифметику int под операцией long (см. mark_wide())
+	 * @param node
+	 * @return
+	 */
+	long long eval_wide(expr_node *node)
+	{
+		long long value, partial_value;
+		int handle, index;
+
+		if (node->op >= OP_NEG && node->op <= OP_MOD && !node->wide)
+			return eval_node(node);
+		switch (node->op)
+		{
+			case OP_CONST:
+				return node->wide ? node->number : node->value;
+			case OP_LONG_VAR:
+				return read_wide(node->name_id);
+			case OP_LONG_ASSIGN:
+				return write_wide(node->name_id, eval_wide(node->right));
+			case OP_NEG:
+				return wide_arithmetic(OP_SUB, 0, eval_wide(node->left));
+			case OP_ADD:
+			case OP_SUB:
+			case OP_MUL:
+				value = eval_wide(node->left);
+				return wide_arithmetic(node->op, value, eval_wide(node->right));
+			case OP_DIV:
+			case OP_MOD:
+				value = eval_wide(node->left);
+				return divide_wide(node->op, value, eval_wide(node->right));
+			case OP_LOWER:
+				return eval_wide(node->left) < eval_wide(node->right);
+			case OP_LOWER_OR_EQUAL:
+				return eval_wide(node->left) <= eval_wide(node->right);
+			case OP_GREATER:
+				return eval_wide(node->left) > eval_wide(node->right);
+			case OP_GREATER_OR_EQUAL:
+				return eval_wide(node->left) >= eval_wide(node->right);
+			case OP_EQUAL:
+				return eval_wide(node->left) == eval_wide(node->right);
+			case OP_NOT_EQUAL:
+				return eval_wide(node->left) != eval_wide(node->right);
+			case OP_INDEX:
+			case OP_INDEX_UNCHECKED:
+				handle = eval_node(node->left);
+				index = eval_node(node->right);
+				if ((unsigned)index >= (unsigned)array_at(handle)->length)
+					runtime_error(INDEX_RANGE);
+				return arrays[handle]->get_wide(index);
+			case OP_STORE:
+			case OP_STORE_UNCHECKED:
+				index = eval_node(node->left);
+				value = eval_wide(node->right);
+				handle = *find_var_slot(node->name_id);
+				if ((unsigned)index >= (unsigned)array_at(handle)->length)
+					runtime_error(INDEX_RANGE);
+				arrays[handle]->set_wide(index, value);
+				return arrays[handle]->get_wide(index);
+			case OP_CALL:
+				if (!node->wide)
+					return call_compiled_function(node);
+				call_compiled_function(node);
+				return wide_result;
+			default:
+				return eval_node(node);
+		}
+	}
+	/**
+	 * Переменная OP_LONG_VAR. Имя, которое в одних блоках функции long, а в
+	 * других int, тоже считается через eval_wide(): тогда тип смотрим здесь
+	 */
+	long long read_wide(int name_id)
+	{
+		long long *cell = long_cell(name_id);
+
+		return cell ? *cell : *find_var_slot(name_id);
+	}
+	/**
+	 * @return значение, которое оказалось в переменной
+	 */
+	long long write_wide(int name_id, long long value)
+	{
+		long long *cell = long_cell(name_id);
+
+		if (cell)
+			return *cell = value;
+		return *find_var_slot(name_id) = (int)value;
+	}
+	/**
+	 * Сложение, вычитание или умножение long, в режиме checked_arithmetic
+	 * с проверкой переполнения
+	 */
+	long long wide_arithmetic(char op, long long value, long long partial_value)
+	{
+		long long result;
+		bool overflow;
+
+		if (op == OP_ADD)
+			overflow = __builtin_add_overflow(value, partial_value, &result);
+		else if (op == OP_SUB)
+			overflow = __builtin_sub_overflow(value, partial_value, &result);
+		else
+			overflow = __builtin_mul_overflow(value, partial_value, &result);
+		if (overflow && checked_arithmetic)
+			runtime_error(OVERFLOW);
+		return result;
+	}
+	/**
+	 * OP_CHECKED: операция int node->relop с проверкой переполнения
+	 */
+	int checked(expr_node *node)
+	{
+		int value, partial_value, result;
+		bool overflow;
+
+		value = node->relop == OP_NEG ? 0 : eval_node(node->left);
+		partial_value = eval_node(node->relop == OP_NEG ? node->left : node->right);
+		if (node->relop == OP_ADD)
+			overflow = __builtin_add_overflow(value, partial_value, &result);
+		else if (node->relop == OP_MUL)
+			overflow = __builtin_mul_overflow(value, partial_value, &result);
+		else
+			overflow = __builtin_sub_overflow(value, partial_value, &result);
+		if (overflow)
+			runtime_error(OVERFLOW);
+		return result;
+	}
+	/**
+	 * Сложение, вычитание, умножение и минус int без проверки: по модулю 2^32,
+	 * как в array_kernels и векторных циклах. Считаем в uint32_t, потому что
+	 * переполнение int в C++ - неопределенное поведение
+	 */
+	static int wrap_add(int value, int partial_value)
+	{
+		return (int)((uint32_t)value + (uint32_t)partial_value);
+	}
+	static int wrap_sub(int value, int partial_value)
+	{
+		return (int)((uint32_t)value - (uint32_t)partial_value);
+	}
+	static int wrap_mul(int value, int partial_value)
+	{
+		return (int)((uint32_t)value * (uint32_t)partial_value);
+	}
+	static int wrap_neg(int value)
+	{
+		return (int)(0u - (uint32_t)value);
+	}
+	/**
+	 * Деление и остаток с проверкой делителя. INT_MIN / -1 не влезает в int,
+	 * а инструкция деления на нем падает с SIGFPE. В режиме checked_arithmetic
+	 * это OVERFLOW и для частного, и для остатка, иначе частное заворачивается
+	 * в INT_MIN, а остаток 0
+	 */
+	int divide(char op, int value, int divisor)
+	{
+		if (divisor == 0)
+		{
+			syntax_error(DIV_BY_ZERO);
+			return 0;
+		}
+		if (divisor == -1 && value == INT_MIN)
+		{
+			if (checked_arithmetic)
+				runtime_error(OVERFLOW);
+			return op == OP_DIV ? INT_MIN : 0;
+		}
+		return op == OP_DIV ? value / divisor : value % divisor;
+	}
+	/// divide() для long: то же с LLONG_MIN / -1
+	long long divide_wide(char op, long long value, long long divisor)
+	{
+		if (divisor == 0)
+		{
+			syntax_error(DIV_BY_ZERO);
+			return 0;
+		}
+		if (divisor == -1 && value == LLONG_MIN)
+		{
+			if (checked_arithmetic)
+				runtime_error(OVERFLOW);
+			return op == OP_DIV ? LLONG_MIN : 0;
+		}
+		return op == OP_DIV ? value / divisor : value % divisor;
+	}
+	/**
+	 * Деление на константу node->value без инструкции деления:
+	 * старшая половина произведения на магическое число и сдвиг (Hacker's Delight, 10-1)
+	 */
+	static int divide_by_magic(expr_node *node, int value)
+	{
+		int q = (int)(((long long)node->magic * value) >> 32);
+
+		if (node->value > 0 && node->magic < 0)
+			q += value;
+		else if (node->value < 0 && node->magic > 0)
+			q -= value;
+		q >>= node->shift;
+		return q + (int)((unsigned)q >> 31);
+	}
+	/**
+	 * Магическое число и сдвиг для деления на d, 2 <= |d| < 2^31
+	 */
+	static void compute_magic(int d, int *magic, int *shift)
+	{
+		const unsigned two31 = 0x80000000u;
+		unsigned ad, anc, delta, q1, r1, q2, r2, t;
+		int p;
+
+		ad = d < 0 ? 0u - (unsigned)d : (unsigned)d;
+		t = two31 + ((unsigned)d >> 31);
+		anc = t - 1 - t % ad;
+		p = 31;
+		q1 = two31 / anc;
+		r1 = two31 - q1 * anc;
+		q2 = two31 / ad;
+		r2 = two31 - q2 * ad;
+		do
+		{
+			p++;
+			q1 = 2 * q1;
+			r1 = 2 * r1;
+			if (r1 >= anc)
+			{
+				q1++;
+				r1 -= anc;
+			}
+			q2 = 2 * q2;
+			r2 = 2 * r2;
+			if (r2 >= ad)
+			{
+				q2++;
+				r2 -= ad;
+			}
+			delta = ad - r2;
+		} while (q1 < delta || (q1 == delta && r1 == 0));
+
+		*magic = (int)(q2 + 1);
+		if (d < 0)
+			*magic = -*magic;
+		*shift = p - 32;
+	}
+	/**
+	 * Вызов пользовательской функции из скомпилированного выражения.
+	 * То же, что call_function(), но аргументы уже разобраны
+	 * @param node
+	 * @return значение, которое вернула функция
+	 */
+	int call_compiled_function(expr_node *node)
+	{
+		int temp[NUM_PARAMS], count = 0, lvartemp;
+		char *temp_source_code_location;
+		expr_node *arg;
+
+		for (arg = node->left; arg; arg = arg->next)
+			temp[count++] = eval_node(arg);
+		if (node->value) /* функция с yield */
+			return make_generator(node->loc, temp, count);
+
+		lvartemp = lvartos;
+		for (count--; count >= 0; count--)
+			local_push(nullptr, ARG, temp[count]);
+		temp_source_code_location = source_code_location;
+		function_push_variables_on_call_stack(lvartemp, temp_source_code_location);
+		source_code_location = node->loc;
+		interpret_function_body();
+		source_code_location = temp_source_code_location;
+		lvartos = func_pop();
+		return ret_value;
+	}
+	/**
+	 * @return значение встроенной функции
+	 */
+	int call_native_node(expr_node *node)
+	{
+		int args[NUM_PARAMS], count = 0;
+		expr_node *arg;
+
+		for (arg = node->left; arg; arg = arg->next)
+			args[count++] = eval_node(arg);
+		return natives[node->value].call(args);
+	}
+	/**
+	 * Выполнить тело функции, аргументы которой уже лежат в local_var_stack.
+	 * Если функция закончилась хвостовым вызовом, ее кадр отдается вызываемой
+	 * функции и тело выполняется снова в этом же цикле - стек не растет.
+	 */
+	void interpret_function_body()
+	{
+		int count;
+
+		for (;;)
+		{
+			count_step();
+			ret_occurring = 0;
+			get_function_parameters();
+			interpret_block();
+			ret_occurring = 0;
+			if (!tail_call)
+				return;
+
+			lvartos = frame_base();
+			release_frame_arrays(call_stack[function_last_index_on_call_stack - 1].arrays);
+			for (count = tail_call_count - 1; count >= 0; count--)
+				local_push(nullptr, ARG, tail_call_args[count]);
+			source_code_location = tail_call->loc;
+			tail_call = nullptr;
+		}
+	}
+	/**
+	 * Есть ли у выражения побочные эффекты (присваивания или вызовы)
+	 */
+	static bool is_pure(expr_node *node)
+	{
+		if (!node)
+			return true;
+		if (node->op == OP_ASSIGN || node->op == OP_STORE || node->op == OP_STORE_UNCHECKED ||
+			node->op == OP_LONG_ASSIGN || node->op == OP_STRING_ASSIGN || node->op == OP_STRING_APPEND ||
+			node->op == OP_CALL || node->op == OP_NATIVE)
+			return false;
+		return is_pure(node->left) && is_pure(node->right) && is_pure(node->other);
+	}
+	/**
+	 * Превратить узел в константу
+	 */
+	static expr_node *make_constant(expr_node *node, int value)
+	{
+		node->op = OP_CONST;
+		node->value = value;
+		node->left = node->right = nullptr;
+		return node;
+	}
+	/**
+	 * Проход оптимизации: свертка константных подвыражений и подстановка
+	 * локальных переменных, которым константа присваивается один раз
+	 * @param node
+	 * @return оптимизированный узел (может быть другим узлом)
+	 */
+	expr_node *optimize_node(expr_node *node)
+	{
+		expr_node *arg;
+		constant_local *constant;
+		int l, r;
+
+		if (node->op == OP_CONST)
+			return node;
+		if (node->op == OP_VAR)
+		{
+			constant = find_constant_local(node);
+			return constant ? make_constant(node, constant->value) : node;
+		}
+		if (node->op == OP_CALL)
+		{
+			for (arg = node->left; arg; arg = arg->next)
+				arg = replace_arg(node, arg, optimize_node(arg));
+			arg = inline_call(node);
+			return arg ? optimize_node(arg) : node;
+		}
+		if (node->op == OP_NATIVE)
+		{
+			for (arg = node->left; arg; arg = arg->next)
+				arg = replace_arg(node, arg, optimize_node(arg));
+			return node;
+		}
+		if (node->op == OP_SELECT)
+		{
+			node->left = optimize_node(node->left);
+			node->right = optimize_node(node->right);
+			node->other = optimize_node(node->other);
+			if (node->left->op == OP_CONST)
+				return node->left->value ? node->right : node->other;
+			return node;
+		}
+		if (node->op == OP_GLOBAL || node->op == OP_WIDE || node->op == OP_TEXT)
+			return node; /* сворачивать нечего; 64-битное поддерево в int не сворачиваем */
+		if (node->left)
+			node->left = optimize_node(node->left);
+		if (node->right)
+			node->right = optimize_node(node->right);
+		if (node->op == OP_CHECKED)
+			return node;
+		if (node->op >= OP_SHIFT_LEFT && node->op <= OP_MOD_MAGIC)
+			return node; /* уже упрощено: тело подставленной функции оптимизируется второй раз */
+
+		if (node->op == OP_NEG)
+			return node->left->op == OP_CONST ? make_constant(node, wrap_neg(node->left->value)) : node;
+		if (node->op == OP_ASSIGN || node->op == OP_STRING_ASSIGN || node->op == OP_STRING_APPEND)
+			return node;
+		if (node->op == OP_INDEX)
+			return prove_index(node, node->left);
+		if (node->op == OP_STORE)
+		{
+			expr_node array = *node;
+
+			array.op = OP_VAR;
+			return prove_index(node, &array);
+		}
+
+		/* (x + c1) + c2 => x + (c1 + c2), так же для умножения */
+		if ((node->op == OP_ADD || node->op == OP_MUL) && node->right->op == OP_CONST &&
+			node->left->op == node->op && node->left->right->op == OP_CONST)
+		{
+			node->left->right->value = node->op == OP_ADD ? wrap_add(node->left->right->value, node->right->value)
+														   : wrap_mul(node->left->right->value, node->right->value);
+			node->right = node->left->right;
+			node->left = node->left->left;
+		}
+
+		if (node->left->op == OP_CONST && node->right->op == OP_CONST)
+		{
+			l = node->left->value;
+			r = node->right->value;
+			switch (node->op)
+			{
+				case OP_ADD: return make_constant(node, wrap_add(l, r));
+				case OP_SUB: return make_constant(node, wrap_sub(l, r));
+				case OP_MUL: return make_constant(node, wrap_mul(l, r));
+				case OP_DIV:
+				case OP_MOD:
+					/* деление на ноль и INT_MIN / -1 оставляем divide(): ошибка, если она
+					 * будет, должна случиться при выполнении */
+					if (!r || (r == -1 && l == INT_MIN))
+						return node;
+					return make_constant(node, node->op == OP_DIV ? l / r : l % r);
+				case OP_LOWER: return make_constant(node, l < r);
+				case OP_LOWER_OR_EQUAL: return make_constant(node, l <= r);
+				case OP_GREATER: return make_constant(node, l > r);
+				case OP_GREATER_OR_EQUAL: return make_constant(node, l >= r);
+				case OP_EQUAL: return make_constant(node, l == r);
+				case OP_NOT_EQUAL: return make_constant(node, l != r);
+			}
+		}
+
+		/* x + 0, x - 0, x * 1, x / 1 => x */
+		if (node->right->op == OP_CONST &&
+			((node->right->value == 0 && (node->op == OP_ADD || node->op == OP_SUB)) ||
+			 (node->right->value == 1 && (node->op == OP_MUL || node->op == OP_DIV))))
+			return node->left;
+		/* 0 + x, 1 * x => x */
+		if (node->left->op == OP_CONST &&
+			((node->left->value == 0 && node->op == OP_ADD) || (node->left->value == 1 && node->op == OP_MUL)))
+			return node->right;
+		/* x * 0 => 0, если x без побочных эффектов */
+		if (node->op == OP_MUL && ((node->right->op == OP_CONST && node->right->value == 0 && is_pure(node->left)) ||
+								   (node->left->op == OP_CONST && node->left->value == 0 && is_pure(node->right))))
+			return make_constant(node, 0);
+		return reduce_strength(node);
+	}
+	/**
+	 * Замена умножения, деления и остатка на константу более дешевыми операциями.
+	 * Делитель-константа не ноль, поэтому проверка DIV_BY_ZERO не нужна.
+	 * x / -1 - это минус с заворачиванием INT_MIN, а в режиме checked_arithmetic
+	 * минус с проверкой; x % -1 - всегда 0
+	 * @param node
+	 * @return
+	 */
+	expr_node *reduce_strength(expr_node *node)
+	{
+		int c, k;
+
+		/* константу умножения переносим вправо */
+		if (node->op == OP_MUL && node->left->op == OP_CONST)
+			std::swap(node->left, node->right);
+		if ((node->op != OP_MUL && node->op != OP_DIV && node->op != OP_MOD) || node->right->op != OP_CONST)
+			return node;
+
+		c = node->right->value;
+		/* -2^31 и 0 оставляем обычному делению */
+		if (c == 0 || c == INT_MIN)
+			return node;
+		k = c > 0 && !(c & (c - 1)) ? __builtin_ctz(c) : -1;
+
+		switch (node->op)
+		{
+			case OP_MUL:
+				if (k < 0)
+					return node;
+				node->op = OP_SHIFT_LEFT;
+				node->value = k;
+				break;
+			case OP_DIV:
+				if (c == -1)
+				{
+					node->op = checked_arithmetic ? OP_CHECKED : OP_NEG;
+					node->relop = OP_NEG;
+					break;
+				}
+				if (k >= 0)
+				{
+					node->op = OP_DIV_POW2;
+					node->value = k;
+					break;
+				}
+				node->op = OP_DIV_MAGIC;
+				node->value = c;
+				compute_magic(c, &node->magic, &node->shift);
+				break;
+			case OP_MOD:
+				if (k >= 0)
+				{
+					node->op = OP_MOD_POW2;
+					node->value = k;
+					break;
+				}
+				if (c == -1)
+				{ /* INT_MIN % -1 в режиме checked_arithmetic - OVERFLOW, его находит divide() */
+					if (checked_arithmetic || !is_pure(node->left))
+						return node;
+					return make_constant(node, 0);
+				}
+				node->op = OP_MOD_MAGIC;
+				node->value = c;
+				compute_magic(c, &node->magic, &node->shift);
+				break;
+		}
+		node->right = nullptr;
+		return node;
+	}
+	/**
+	 * Подставить тело маленькой функции в место вызова вместо call_compiled_function().
+	 * Аргументы должны быть без побочных эффектов: в теле они могут считаться несколько раз.
+	 * @param call
+	 * @return новое дерево или nullptr, если вызов остается вызовом
+	 */
+	expr_node *inline_call(expr_node *call)
+	{
+		int function, count = 0;
+		expr_node *args[NUM_PARAMS], *arg, *body;
+
+		if (inline_budget <= 0)
+			return nullptr;
+		for (function = 0; function < function_position; function++)
+			if (function_table[function].loc == call->loc)
+				break;
+		if (function == function_position || !(body = inline_template(function)))
+			return nullptr;
+
+		for (arg = call->left; arg; arg = arg->next)
+		{
+			if (!is_pure(arg))
+				return nullptr;
+			args[count++] = arg;
+		}
+		if (count != (int)function_table[function].params.size())
+			return nullptr;
+
+		body = clone_node(body, args);
+		/* аргументы размножились по телу - не раздуваем выражение больше двух бюджетов */
+		if (count_nodes(body) > inline_budget * 2)
+			return nullptr;
+		return body;
+	}
+	/**
+	 * Тело функции для подстановки. Подставляются функции вида
+	 *   { return E; }
+	 *   { if (C) { return E1; } return E2; }
+	 *   { if (C) { return E1; } else { return E2; } }
+	 * где выражения без присваиваний и вызовов и не больше inline_budget узлов.
+	 * Параметры в теле заменены на OP_PARAM, глобальные переменные - на OP_GLOBAL.
+	 * @param function
+	 * @return nullptr если функцию подставлять нельзя
+	 */
+	expr_node *inline_template(int function)
+	{
+		function_type &f = function_table[function];
+		char saved_token[80];
+		char saved_type, saved_datatype;
+		char *saved_location;
+		expr_node *body = nullptr, *condition, *then_value, *else_value;
+
+		if (f.inline_state)
+			return f.inline_state == 2 ? f.inline_body : nullptr; /* 1 - функция рекурсивная */
+		f.inline_state = 1;
+
+		saved_location = source_code_location;
+		strcpy_s(saved_token, 80, current_token);
+		saved_type = token_type;
+		saved_datatype = current_tok_datatype;
+
+		source_code_location = f.loc;
+		f.params.clear();
+		do
+		{ /* список параметров */
+			get_next_token();
+			if (*current_token == ')')
+				break;
+			if (current_tok_datatype != INT && current_tok_datatype != CHAR)
+				break;
+			get_next_token();
+			if (token_type != VARIABLE)
+				break;
+			f.params.emplace_back(current_token);
+			get_next_token();
+		} while (*current_token == ',');
+
+		if (*current_token == ')' && inline_token("{"))
+		{
+			get_next_token();
+			if (current_tok_datatype == RETURN)
+				body = inline_return_value();
+			else if (current_tok_datatype == IF && (condition = inline_condition()) &&
+					 inline_keyword(RETURN) && (then_value = inline_return_value()) && inline_token("}"))
+			{
+				get_next_token();
+				if (current_tok_datatype == ELSE)
+				{
+					if (inline_token("{") && inline_keyword(RETURN) &&
+						(else_value = inline_return_value()) && inline_token("}"))
+						body = new_node(OP_SELECT, condition, then_value);
+				}
+				else if (current_tok_datatype == RETURN && (else_value = inline_return_value()))
+					body = new_node(OP_SELECT, condition, then_value);
+				if (body)
+					body->other = else_value;
+			}
+			if (body && !inline_token("}"))
+				body = nullptr;
+		}
+
+		if (body && is_pure(body) && count_nodes(body) <= inline_budget)
+			f.inline_body = make_template(body, f);
+		f.inline_state = 2;
+
+		source_code_location = saved_location;
+		strcpy_s(current_token, 80, saved_token);
+		token_type = saved_type;
+		current_tok_datatype = saved_datatype;
+		return f.inline_body;
+	}
+	/* Следующий токен равен token */
+	bool inline_token(const char *token)
+	{
+		get_next_token();
+		return !strcmp(current_token, token);
+	}
+	/* Следующий токен - ключевое слово keyword */
+	bool inline_keyword(int keyword)
+	{
+		return get_next_token() == KEYWORD && current_tok_datatype == keyword;
+	}
+	/* Выражение после return вместе с ; */
+	expr_node *inline_return_value()
+	{
+		compiled_expression *compiled = compiled_expression_at(source_code_location);
+
+		if (!compiled || strcmp(compiled->terminator, ";"))
+			return nullptr;
+		source_code_location = compiled->end;
+		get_next_token();
+		return compiled->root;
+	}
+	/* Условие после if вместе с { */
+	expr_node *inline_condition()
+	{
+		compiled_expression *compiled = compiled_expression_at(source_code_location);
+
+		if (!compiled || strcmp(compiled->terminator, "{"))
+			return nullptr;
+		source_code_location = compiled->end;
+		get_next_token();
+		return compiled->root;
+	}
+	/**
+	 * Копия тела функции, где переменные заменены на параметры и глобальные переменные
+	 * @return nullptr если в теле есть неизвестная переменная
+	 */
+	expr_node *make_template(expr_node *node, function_type &f)
+	{
+		expr_node *copy;
+		int i;
+
+		if (!node || node->op == OP_WIDE)
+			return nullptr; /* long в подставляемых функциях не бывает */
+		copy = memory.make<expr_node>(*node);
+		copy->next = nullptr;
+		if (node->op == OP_VAR)
+		{
+			for (i = 0; i < (int)f.params.size(); i++)
+				if (f.params[i] == node->name)
+				{
+					copy->op = OP_PARAM;
+					copy->value = i;
+					return copy;
+				}
+			for (i = 0; i < global_variable_position; i++)
+				if (global_vars[i].name_id == node->name_id)
+				{
+					copy->op = OP_GLOBAL;
+					copy->value = i;
+					return copy;
+				}
+			return nullptr;
+		}
+		if ((node->left && !(copy->left = make_template(node->left, f))) ||
+			(node->right && !(copy->right = make_template(node->right, f))) ||
+			(node->other && !(copy->other = make_template(node->other, f))))
+			return nullptr;
+		return copy;
+	}
+	/**
+	 * Глубокая копия дерева, OP_PARAM заменяются копиями аргументов вызова
+	 */
+	expr_node *clone_node(expr_node *node, expr_node **args)
+	{
+		expr_node *copy, *arg, **last_arg;
+
+		if (!node)
+			return nullptr;
+		if (node->op == OP_PARAM && args)
+			return clone_node(args[node->value], nullptr);
+		copy = memory.make<expr_node>(*node);
+		copy->next = nullptr;
+		if (node->op == OP_CALL || node->op == OP_NATIVE)
+		{ /* аргументы вызова - список через next */
+			last_arg = &copy->left;
+			for (arg = node->left; arg; arg = arg->next)
+			{
+				*last_arg = clone_node(arg, args);
+				last_arg = &(*last_arg)->next;
+			}
+			return copy;
+		}
+		copy->left = clone_node(node->left, args);
+		copy->right = clone_node(node->right, args);
+		copy->other = clone_node(node->other, args);
+		return copy;
+	}
+	/**
+	 * Количество узлов в дереве
+	 */
+	static int count_nodes(expr_node *node)
+	{
+		if (!node)
+			return 0;
+		return 1 + count_nodes(node->left) + count_nodes(node->right) + count_nodes(node->other);
+	}
+	/**
+	 * Слияние частых сочетаний узлов в суперинструкции, чтобы на каждую итерацию
+	 * горячего цикла приходилось меньше переходов по eval_node().
+	 * Пары выбраны по --op-stats на программах из corpus/:
+	 *   x = x + c     => OP_ADD_TO_VAR
+	 *   x = x + y     => OP_ADD_VAR_TO_VAR
+	 *   x < c, x < y  => OP_COMPARE_VAR_CONST, OP_COMPARE_VAR_VAR
+	 * Шаг и условие for сливаются в OP_STEP_AND_TEST в compiled_for_at().
+	 * @param node копия дерева, ее можно менять
+	 * @return
+	 */
+	expr_node *fuse_node(expr_node *node)
+	{
+		expr_node *sum, *arg;
+
+		if (!node || node->op == OP_WIDE)
+			return node;
+		if (node->op == OP_CALL || node->op == OP_NATIVE)
+		{
+			for (arg = node->left; arg; arg = arg->next)
+				arg = replace_arg(node, arg, fuse_node(arg));
+			return node;
+		}
+		node->left = fuse_node(node->left);
+		node->right = fuse_node(node->right);
+		node->other = fuse_node(node->other);
+
+		if (node->op == OP_ASSIGN && (node->right->op == OP_ADD || node->right->op == OP_SUB))
+		{
+			sum = node->right;
+			/* c + x => x + c */
+			if (sum->op == OP_ADD && sum->left->op == OP_CONST && sum->right->op == OP_VAR)
+				std::swap(sum->left, sum->right);
+			if (sum->left->op == OP_VAR && !strcmp(sum->left->name, node->name))
+			{
+				if (sum->right->op == OP_CONST)
+				{
+					node->op = OP_ADD_TO_VAR;
+					node->value = sum->op == OP_ADD ? sum->right->value : -sum->right->value;
+					node->right = nullptr;
+				}
+				else if (sum->op == OP_ADD && sum->right->op == OP_VAR)
+				{
+					node->op = OP_ADD_VAR_TO_VAR;
+					node->left = sum->right;
+					node->right = nullptr;
+				}
+			}
+			return node;
+		}
+		if (node->op >= OP_LOWER && node->op <= OP_NOT_EQUAL && node->left->op == OP_VAR &&
+			(node->right->op == OP_CONST || node->right->op == OP_VAR))
+		{
+			node->relop = (char)(LOWER + node->op - OP_LOWER);
+			strcpy_s(node->name, ID_LEN, node->left->name);
+			node->name_id = node->left->name_id;
+			if (node->right->op == OP_CONST)
+			{
+				node->op = OP_COMPARE_VAR_CONST;
+				node->value = node->right->value;
+				node->left = nullptr;
+			}
+			else
+			{
+				node->op = OP_COMPARE_VAR_VAR;
+				node->left = node->right;
+			}
+			node->right = nullptr;
+		}
+		return node;
+	}
+	/**
+	 * Сравнение для слитых узлов
+	 */
+	static int compare(char relop, int value, int partial_value)
+	{
+		switch (relop)
+		{
+			case LOWER:
+				return value < partial_value;
+			case LOWER_OR_EQUAL:
+				return value <= partial_value;
+			case GREATER:
+				return value > partial_value;
+			case GREATER_OR_EQUAL:
+				return value >= partial_value;
+			case EQUAL:
+				return value == partial_value;
+			default:
+				return value != partial_value;
+		}
+	}
+	/**
+	 * Учесть пары родитель-потомок для --op-stats
+	 */
+	void count_op_pairs(expr_node *node)
+	{
+		expr_node *arg;
+
+		op_counts[node->op]++;
+		if (node->op == OP_CALL || node->op == OP_NATIVE)
+		{
+			for (arg = node->left; arg; arg = arg->next)
+				op_pair_counts[node->op * OP_COUNT + arg->op]++;
+			return;
+		}
+		if (node->left)
+			op_pair_counts[node->op * OP_COUNT + node->left->op]++;
+		if (node->right)
+			op_pair_counts[node->op * OP_COUNT + node->right->op]++;
+		if (node->other)
+			op_pair_counts[node->op * OP_COUNT + node->other->op]++;
+	}
+	/**
+	 * Напечатать самые частые пары операций
+	 */
+	void print_op_stats()
+	{
+		static const char *names[OP_COUNT] = {"const", "var", "assign", "call", "native", "neg", "+", "-", "*", "/", "%",
+											  "<", "<=", ">", ">=", "==", "!=", "<<", "/>>", "%&", "/magic", "%magic",
+											  "global", "param", "select", "[]", "[]=", "[]!", "[]=!", "long", "long=", "wide", "checked", "text", "string=", "string+=", "+=c", "+=var", "cmp-c", "cmp-var",
+											  "step-test"};
+		std::vector<std::pair<long long, int>> pairs;
+		long long total = 0;
+		int i;
+
+		for (i = 0; i < OP_COUNT; i++)
+			total += op_counts[i];
+		for (i = 0; i < OP_COUNT * OP_COUNT; i++)
+			if (op_pair_counts[i])
+				pairs.emplace_back(op_pair_counts[i], i);
+		std::sort(pairs.rbegin(), pairs.rend());
+
+		std::cerr << "[op-stats] узлов выполнено: " << total << std::endl;
+		for (i = 0; i < (int)pairs.size() && i < 12; i++)
+			std::cerr << "[op-stats] " << names[pairs[i].second / OP_COUNT] << " -> " << names[pairs[i].second % OP_COUNT]
+				 << ": " << pairs[i].first << std::endl;
+	}
+	/**
+	 * Заменить аргумент вызова в списке аргументов
+	 * @return новый аргумент
+	 */
+	static expr_node *replace_arg(expr_node *call, expr_node *old_arg, expr_node *new_arg)
+	{
+		expr_node **p;
+
+		if (old_arg == new_arg)
+			return new_arg;
+		for (p = &call->left; *p != old_arg; p = &(*p)->next)
+			;
+		new_arg->next = old_arg->next;
+		*p = new_arg;
+		return new_arg;
+	}
+	/**
+	 * Найти константу, которой равна переменная узла в этом месте функции
+	 * @param node
+	 * @return nullptr если переменная не константа
+	 */
+	constant_local *find_constant_local(expr_node *node)
+	{
+		if (optimizing_function < 0)
+			return nullptr;
+		for (auto &constant : function_table[optimizing_function].constants)
+			if (!strcmp(constant.variable_name, node->name) && node->source > constant.valid_from)
+				return &constant;
+		return nullptr;
+	}
+	/**
+	 * Найти в функции локальные переменные, которые объявлены и один раз получают
+	 * константу на верхнем уровне тела функции. После такого присваивания
+	 * переменную можно заменить ее значением.
+	 * Заодно запоминает массивы, длина которых известна: объявленные один раз на
+	 * верхнем уровне и глобальные, которые ничем не перекрыты.
+	 * @param function
+	 */
+	void analyze_function_constants(int function)
+	{
+		struct candidate
+		{
+			char variable_name[ID_LEN];
+			int declarations;
+			int assignments;
+			char *declared_at;
+			char *assigned_at; /* начало присваивания на верхнем уровне, иначе nullptr */
+			int array_length;  /* из объявления name[N], -1 - размер не константа */
+			int long_declarations; /* объявлена long name; */
+			bool long_array;	   /* объявлена long name[N]; */
+			int string_declarations; /* объявлена string name; */
+		};
+		std::vector<candidate> candidates;
+		std::vector<int> parameters, string_parameters;
+		char saved_token[80];
+		char saved_type, saved_datatype;
+		char *saved_location, *name_location;
+		char previous = '{';
+		int brace = 0, paren = 0, declaring = 0, parameter_type = 0;
+		compiled_expression *compiled;
+
+		function_table[function].analyzed = 1;
+		saved_location = source_code_location;
+		strcpy_s(saved_token, 80, current_token);
+		saved_type = token_type;
+		saved_datatype = current_tok_datatype;
+
+		source_code_location = function_table[function].loc; /* сразу за ( */
+		do
+		{
+			get_next_token();
+			if (token_type == KEYWORD)
+				parameter_type = current_tok_datatype;
+			else if (token_type == VARIABLE)
+			{
+				parameters.push_back(variable_id(current_token));
+				if (parameter_type == STR)
+					string_parameters.push_back(variable_id(current_token));
+			}
+		} while (*current_token != ')' && current_tok_datatype != FINISHED);
+
+		auto find_candidate = [&](const char *name) -> candidate & {
+			for (auto &c : candidates)
+				if (!strcmp(c.variable_name, name))
+					return c;
+			candidates.push_back(candidate{});
+			strcpy_s(candidates.back().variable_name, ID_LEN, name);
+			return candidates.back();
+		};
+
+		while (source_code_location < function_table[function].end)
+		{
+			get_next_token();
+			if (current_tok_datatype == FINISHED)
+				break;
+			if (token_type == BLOCK)
+				brace += *current_token == '{' ? 1 : -1;
+			else if (*current_token == '(')
+				paren++;
+			else if (*current_token == ')')
+				paren--;
+			else if (*current_token == ';')
+				declaring = 0;
+			else if (current_tok_datatype == INT || current_tok_datatype == CHAR || current_tok_datatype == LONG ||
+					 current_tok_datatype == STR)
+				declaring = current_tok_datatype == LONG ? 2 : current_tok_datatype == STR ? 3 : 1;
+			else if (token_type == VARIABLE && declaring)
+			{
+				candidate &c = find_candidate(current_token);
+				c.declarations++;
+				if (brace == 1 && paren == 0)
+					c.declared_at = source_code_location;
+				name_location = source_code_location;
+				get_next_token();
+				if (*current_token == '[')
+				{
+					get_next_token();
+					c.array_length = token_type == NUMBER ? atoi(current_token) : -1;
+					c.long_array |= declaring == 2;
+					get_next_token();
+				}
+				else if (declaring == 2)
+					c.long_declarations++;
+				else if (declaring == 3)
+					c.string_declarations++;
+				if (*current_token != ']')
+				{
+					source_code_location = name_location;
+					*current_token = '\0';
+				}
+			}
+			else if (token_type == VARIABLE)
+			{
+				name_location = source_code_location - strlen(current_token);
+				candidate &c = find_candidate(current_token);
+				bool top_level = brace == 1 && paren == 0 && strchr(";{}", previous);
+				get_next_token();
+				if (token_type == DELIMITER && *current_token == '=')
+				{
+					c.assignments++;
+					if (top_level)
+						c.assigned_at = name_location;
+				}
+				source_code_location = name_location + strlen(c.variable_name);
+				*current_token = '\0';
+			}
+			previous = token_type == DELIMITER || token_type == BLOCK ? *current_token : '\0';
+		}
+
+		/* массивы нужны уже при компиляции присваиваний ниже */
+		for (auto &c : candidates)
+			if (c.declarations == 1 && c.declared_at && c.array_length > 0 && c.array_length <= max_array_size)
+				function_table[function].arrays.push_back({variable_id(c.variable_name), c.array_length, c.declared_at});
+			else if (c.array_length)
+				function_table[function].arrays.push_back({variable_id(c.variable_name), 0, function_table[function].end});
+		for (int i = 0; i < global_variable_position; i++)
+		{
+			int name_id = global_vars[i].name_id;
+			bool hidden = std::find(parameters.begin(), parameters.end(), name_id) != parameters.end();
+
+			for (auto &c : candidates)
+				hidden |= c.declarations > 0 && variable_id(c.variable_name) == name_id;
+			if (global_lengths[i] && !hidden)
+				function_table[function].arrays.push_back({name_id, global_lengths[i], function_table[function].loc});
+			if (global_vars[i].variable_type == LONG && !hidden)
+				(global_lengths[i] ? function_table[function].long_arrays : function_table[function].long_names).push_back(name_id);
+			else if (global_vars[i].variable_type == LONG && !global_lengths[i])
+				function_table[function].unsure_names.push_back(name_id); /* где-то имя означает глобальную long */
+			if (global_vars[i].variable_type == STR)
+				(hidden ? function_table[function].mixed_string_names : function_table[function].string_names).push_back(name_id);
+		}
+		for (auto &c : candidates)
+		{
+			int name_id = variable_id(c.variable_name);
+			bool parameter = std::find(parameters.begin(), parameters.end(), name_id) != parameters.end();
+			bool string_parameter = std::find(string_parameters.begin(), string_parameters.end(), name_id) != string_parameters.end();
+
+			if (c.long_array)
+				function_table[function].long_arrays.push_back(name_id);
+			if (c.long_declarations && c.long_declarations == c.declarations && !parameter)
+				function_table[function].long_names.push_back(name_id);
+			else if (c.long_declarations)
+				function_table[function].unsure_names.push_back(name_id);
+			if ((c.string_declarations || string_parameter) && c.string_declarations == c.declarations &&
+				(string_parameter || !parameter))
+				function_table[function].string_names.push_back(name_id);
+			else if (c.string_declarations || string_parameter)
+				function_table[function].mixed_string_names.push_back(name_id);
+		}
+
+		/* присваивания обрабатываем по порядку в коде, чтобы константы цеплялись друг за друга */
+		for (;;)
+		{
+			candidate *next = nullptr;
+			for (auto &c : candidates)
+				if (c.declarations == 1 && c.assignments == 1 && !c.array_length && c.declared_at && c.assigned_at &&
+					c.declared_at < c.assigned_at && (!next || c.assigned_at < next->assigned_at))
+					next = &c;
+			if (!next)
+				break;
+			compiled = compiled_expression_at(next->assigned_at);
+			if (compiled && compiled->root->op == OP_ASSIGN && compiled->root->right->op == OP_CONST)
+			{
+				constant_local constant{};
+				strcpy_s(constant.variable_name, ID_LEN, next->variable_name);
+				constant.value = compiled->root->right->value;
+				constant.valid_from = compiled->end;
+				function_table[function].constants.push_back(constant);
+			}
+			next->assignments = 0;
+		}
+
+		function_table[function].analyzed = 2;
+		source_code_location = saved_location;
+		strcpy_s(current_token, 80, saved_token);
+		token_type = saved_type;
+		current_tok_datatype = saved_datatype;
+	}
+	/**
+	 * Записать дерево выражения в виде текста для отладочной печати
+	 * @param node
+	 * @param out
+	 */
+	static void dump_node(expr_node *node, std::string &out)
+	{
+		static const char *binary_ops[] = {"+", "-", "*", "/", "%", "<", "<=", ">", ">=", "==", "!="};
+		expr_node *arg;
+
+		switch (node->op)
+		{
+			case OP_CONST:
+				out += node->wide ? std::to_string(node->number) : std::to_string(node->value);
+				return;
+			case OP_VAR:
+			case OP_LONG_VAR:
+				out += node->name;
+				return;
+			case OP_ASSIGN:
+			case OP_LONG_ASSIGN:
+			case OP_STRING_ASSIGN:
+				out += node->name;
+				out += " = ";
+				dump_node(node->right, out);
+				return;
+			case OP_STRING_APPEND:
+				out += node->name;
+				out += " += ";
+				dump_node(node->right, out);
+				return;
+			case OP_TEXT:
+				out += "\"";
+				out += node->source;
+				out += "\"";
+				return;
+			case OP_WIDE:
+				out += "(int)";
+				dump_node(node->left, out);
+				return;
+			case OP_CHECKED:
+				out += "checked(";
+				if (node->relop == OP_NEG)
+					out += "-";
+				dump_node(node->left, out);
+				if (node->relop != OP_NEG)
+				{
+					out += " ";
+					out += binary_ops[node->relop - OP_ADD];
+					out += " ";
+					dump_node(node->right, out);
+				}
+				out += ")";
+				return;
+			case OP_CALL:
+			case OP_NATIVE:
+				out += node->name;
+				out += "(";
+				for (arg = node->left; arg; arg = arg->next)
+				{
+					dump_node(arg, out);
+					if (arg->next)
+						out += ", ";
+				}
+				out += ")";
+				return;
+			case OP_NEG:
+				out += "-";
+				dump_node(node->left, out);
+				return;
+			case OP_GLOBAL:
+				out += node->name;
+				return;
+			case OP_INDEX:
+			case OP_INDEX_UNCHECKED:
+				dump_node(node->left, out);
+				out += "[";
+				dump_node(node->right, out);
+				out += "]";
+				return;
+			case OP_STORE:
+			case OP_STORE_UNCHECKED:
+				out += node->name;
+				out += "[";
+				dump_node(node->left, out);
+				out += "] = ";
+				dump_node(node->right, out);
+				return;
+			case OP_PARAM:
+				out += "$" + std::to_string(node->value);
+				return;
+			case OP_ADD_TO_VAR:
+				out += node->name;
+				out += " += ";
+				out += std::to_string(node->value);
+				return;
+			case OP_ADD_VAR_TO_VAR:
+				out += node->name;
+				out += " += ";
+				out += node->left->name;
+				return;
+			case OP_COMPARE_VAR_CONST:
+			case OP_COMPARE_VAR_VAR:
+				out += "(";
+				out += node->name;
+				out += " ";
+				out += binary_ops[OP_LOWER - OP_ADD + node->relop - LOWER];
+				out += "# ";
+				out += node->op == OP_COMPARE_VAR_CONST ? std::to_string(node->value) : std::string(node->left->name);
+				out += ")";
+				return;
+			case OP_SELECT:
+				out += "(";
+				dump_node(node->left, out);
+				out += " ? ";
+				dump_node(node->right, out);
+				out += " : ";
+				dump_node(node->other, out);
+				out += ")";
+				return;
+			case OP_SHIFT_LEFT:
+			case OP_DIV_POW2:
+			case OP_MOD_POW2:
+			case OP_DIV_MAGIC:
+			case OP_MOD_MAGIC:
+				out += "(";
+				dump_node(node->left, out);
+				out += node->op == OP_SHIFT_LEFT ? " << " : node->op == OP_DIV_POW2 ? " />> " :
+						node->op == OP_MOD_POW2 ? " %& " : node->op == OP_DIV_MAGIC ? " /magic " : " %magic ";
+				out += std::to_string(node->op == OP_MOD_POW2 ? (1 << node->value) - 1 : node->value);
+				out += ")";
+				return;
+			default:
+				out += "(";
+				dump_node(node->left, out);
+				out += " ";
+				out += binary_ops[node->op - OP_ADD];
+				out += " ";
+				dump_node(node->right, out);
+				out += ")";
+		}
+	}
+
+
+	/// TODO вынести все стандартные функции в наследуемый класс
+	/* Get a character from console. (Use getchar() if
+   your compiler does not support       _getche().) */
+	int call_getche(void)
+	{
+		char ch;
+
+		flush_output();
+#if defined(_QC)
+		ch = (char)getche();
+#elif defined(_MSC_VER)
+		ch = (char)_getche();
+#else
+		ch = (char)input_from->read_char();
+#endif
+		return ch;
+	}
+	/* Put a character to the display. */
+	int call_putch(int value)
+	{
+		output_char((char)value);
+		return value;
+	}
+	/* Call puts(). */
+	int call_puts(void)
+	{
+		/* Если при вызове puts() у нас нет открытия скобок функции и внутри нет никакой строки,
+		а так же после функции не стоит ;
+		Проверяем синтаксис на подобные ошибки
+		Спрашивается, нахрена тогда было до этого делать другой анализатор кода,
+		если в итоге был сделан этот костыль */
+		get_next_token();
+		if (*current_token != '(')
+			syntax_error(PAREN_EXPECTED);
+		get_next_token();
+		if (token_type == STRING)
+			output(current_token, strlen(current_token));
+		else
+		{ /* значение string */
+			int handle;
+			array_data *text;
+
+			shift_source_code_location_back();
+			eval_expression(&handle);
+			text = string_at(handle);
+			output(text->bytes, text->length);
+		}
+		output_char('\n');
+		get_next_token();
+		if (*current_token != ')')
+			syntax_error(PAREN_EXPECTED);
+
+		get_next_token();
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+		shift_source_code_location_back();
+		return 0;
+	}
+	/* Аналог printf() */
+	int print(void)
+	{
+		long long value;
+
+		get_next_token();
+		if (*current_token != '(')
+			syntax_error(PAREN_EXPECTED);
+
+		get_next_token();
+		if (token_type == STRING)
+		{ /* выводим строку */
+			output(current_token, strlen(current_token));
+			output_char(' ');
+		}
+		else
+		{ /* выводим число */
+			shift_source_code_location_back();
+			eval_wide_expression(&value);
+			output_number(value);
+			output_char(' ');
+		}
+
+		get_next_token();
+
+		if (*current_token != ')')
+			syntax_error(PAREN_EXPECTED);
+
+		get_next_token();
+		if (*current_token != ';')
+			syntax_error(SEMICOLON_EXPECTED);
+		shift_source_code_location_back();
+		return 0;
+	}
+	/**
+	 * spawn(функция, аргументы...) - запустить функцию программы в пуле потоков.
+	 * Задача получает копию глобальных переменных на момент spawn(): ее записи
+	 * в них видны только ей самой, результат возвращается через join()
+	 * @return описатель задачи для join()
+	 */
+	int call_spawn(void)
+	{
+		char function[ID_LEN];
+		int args[NUM_PARAMS], count = 0, value;
+
+		get_next_token();
+		if (*current_token != '(')
+			syntax_error(PAREN_EXPECTED);
+		get_next_token();
+		if (token_type != VARIABLE || !find_function_in_function_table(current_token))
+			runtime_error(FUNC_UNDEFINED);
+		strcpy_s(function, ID_LEN, current_token);
+
+		get_next_token();
+		while (*current_token == ',')
+		{
+			eval_expression(&value);
+			if (count == NUM_PARAMS)
+				runtime_error(PARAM_ERR);
+			args[count++] = value;
+			get_next_token();
+		}
+		if (*current_token != ')')
+			syntax_error(PAREN_EXPECTED);
+		/* vector только здесь: пока разбираются аргументы, runtime_error() может сделать longjmp */
+		return start_task(function, std::vector<int>(args, args + count));
+	}
+	int start_task(const std::string &function, const std::vector<int> &args);
+	int join(int handle);
+	Scheduler &task_pool();
+	std::unique_ptr<LittleC> make_task_context();
+	int wait_task(int id);
+	void exec_parfor();
+	void wake_channel(channel *target, bool senders);
+
+	/**
+	 * chan(n) - новый канал; емкость n округляется вверх до степени двойки
+	 * @return описатель для send() и recv()
+	 */
+	int make_channel(int size)
+	{
+		size_t capacity = 2;
+
+		if (size <= 0 || size > (1 << 24))
+			runtime_error(PARAM_ERR);
+		while (capacity < (size_t)size)
+			capacity <<= 1;
+		if (!channels)
+			channels = std::make_shared<channel_table>();
+
+		std::lock_guard<std::mutex> guard(channels->lock);
+		channels->channels.push_back(std::make_unique<channel>(capacity));
+		return (int)channels->channels.size() - 1;
+	}
+	channel *find_channel(int handle)
+	{
+		if (handle >= 0 && handle < (int)channel_cache.size() && channel_cache[handle])
+			return channel_cache[handle];
+		if (!channels)
+			runtime_error(PARAM_ERR);
+
+		/* под lock_guard ошибку не поднимаем: мьютекс таблицы остался бы захваченным */
+		bool found;
+		{
+			std::lock_guard<std::mutex> guard(channels->lock);
+			found = handle >= 0 && handle < (int)channels->channels.size();
+			if (found)
+			{
+				channel_cache.resize(channels->channels.size(), nullptr);
+				channel_cache[handle] = channels->channels[handle].get();
+			}
+		}
+		if (!found)
+			runtime_error(PARAM_ERR);
+		return channel_cache[handle];
+	}
+	/**
+	 * Ждать, пока в канале появится место (sending) или значение. В
+	 * планировщике контекст отдает поток, вне его ждет на condition_variable
+	 */
+	void wait_channel(channel *target, bool sending)
+	{
+		if (in_scheduler && state == CONTEXT_RUNNING)
+		{
+			flush_output();
+			blocked_on = target;
+			blocked_sending = sending;
+			state = CONTEXT_BLOCKED;
+			swapcontext(&running_fiber->script, &running_fiber->host);
+			blocked_on = nullptr;
+			return;
+		}
+		std::unique_lock<std::mutex> guard(target->lock);
+
+		target->waiting++;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		target->changed.wait(guard, [target, sending] { return sending ? target->can_send() : target->can_recv(); });
+		target->waiting--;
+	}
+	/// send(канал, значение) - ждет, если канал полон
+	int channel_send(int handle, int value)
+	{
+		channel *target = find_channel(handle);
+
+		while (!target->try_send(value))
+			wait_channel(target, true);
+		wake_channel(target, false);
+		return value;
+	}
+	/// recv(канал) - ждет, если канал пуст
+	int channel_recv(int handle)
+	{
+		channel *target = find_channel(handle);
+		int value;
+
+		while (!target->try_recv(value))
+			wait_channel(target, false);
+		wake_channel(target, true);
+		return value;
+	}
+
+	/// Общее для задач одного parfor: пространство итераций и частичные результаты
+	struct parfor_loop
+	{
+		char *body = nullptr;			/* перед { тела */
+		std::string variable;				/* переменная цикла */
+		long long first = 0;
+		long long step = 1;
+		long long count = 0;			/* сколько итераций */
+		std::atomic<long long> next{0};		/* первая итерация, которую еще никто не взял */
+		unsigned workers = 1;
+		std::vector<std::pair<std::string, int>> reductions;	/* имя и reduction_ops */
+		std::vector<int> partial;			/* workers * reductions.size() */
+		struct local_variable
+		{
+			std::string name;
+			int type;
+			int value;
+		};
+		std::vector<local_variable> locals;	/* кадр функции, в которой стоит parfor */
+	};
+	/**
+	 * Задача parfor номер slot: берет куски итераций, пока они есть. Кусок -
+	 * остаток, деленный на удвоенное число задач, так что в начале куски
+	 * крупные, а к концу мельчают и выравнивают нагрузку потоков
+	 */
+	int run_parfor_chunks(const std::shared_ptr<parfor_loop> &loop, unsigned slot)
+	{
+		return resumable([this, loop, slot] { return parfor_chunks(*loop, slot); });
+	}
+	int parfor_chunks(parfor_loop &loop, unsigned slot)
+	{
+		long long begin, size;
+		int frame_size, variable, i;
+
+		switch (setjmp(execution_buffer))
+		{
+			case RUN_ABORTED:
+				flush_output();
+				return 1;
+			case RUN_ENDED:
+				flush_output();
+				return 0;
+		}
+		reset_stacks();
+
+		function_push_variables_on_call_stack(0, nullptr);
+		for (auto &local : loop.locals)
+			local_push(local.name.c_str(), local.type, local.value);
+		frame_size = lvartos;
+		variable = variable_id(loop.variable.c_str());
+		for (auto &[name, op] : loop.reductions)
+			*find_var_slot(variable_id(name.c_str())) = op == REDUCE_SUM ? 0 : op == REDUCE_MIN ? INT_MAX : INT_MIN;
+
+		for (;;)
+		{
+			begin = loop.next.load();
+			do
+			{
+				if (begin >= loop.count)
+					break;
+				size = std::max(1LL, (loop.count - begin) / (2 * loop.workers));
+			} while (!loop.next.compare_exchange_weak(begin, begin + size));
+			if (begin >= loop.count)
+				break;
+
+			for (; size > 0; size--, begin++)
+			{
+				count_step();
+				*find_var_slot(variable) = (int)(loop.first + begin * loop.step);
+				source_code_location = loop.body;
+				interpret_block();
+				if (ret_occurring || break_occurring)
+					runtime_error(PARFOR_EXIT);
+				lvartos = frame_size; /* переменные, объявленные в теле */
+			}
+		}
+
+		for (i = 0; i < (int)loop.reductions.size(); i++)
+			loop.partial[slot * loop.reductions.size() + i] = *find_var_slot(variable_id(loop.reductions[i].first.c_str()));
+		flush_output();
+		return 0;
+	}
+	/* Считываем ЦЕЛЫЕ числа из строки в сосноли. */
+	int getnum(void)
+	{
+		int value;
+
+		if (record_mode) /* в режиме --each-line - следующее число текущей строки */
+			return next_record_number();
+		flush_output(); /* подсказка для ввода должна быть видна */
+		input_status = input_from->read_number(value);
+		return value;
+	}
+	/**
+	 * readnums(массив, n) - прочитать до n чисел в начало массива
+	 * @return сколько прочитано; почему меньше n - в instatus()
+	 */
+	int readnums(int handle, int count)
+	{
+		array_data *target = array_at(handle);
+		int read, value;
+
+		if (count < 0 || count > target->length)
+			runtime_error(INDEX_RANGE);
+		if (!record_mode)
+			flush_output();
+		for (read = 0; read < count; read++)
+		{
+			if (record_mode)
+				value = next_record_number();
+			else
+				input_status = input_from->read_number(value);
+			if (input_status != INPUT_OK)
+				break;
+			target->set(read, value);
+		}
+		return read;
+	}
+	/**
+	 * Первые count элементов массива для встроенных функций a...()
+	 * @param minimum меньше скольких элементов быть не может
+	 */
+	array_data *array_prefix(int handle, int count, int minimum = 0)
+	{
+		array_data *target = array_at(handle);
+
+		if (count < minimum || count > target->length)
+			runtime_error(INDEX_RANGE);
+		return target;
+	}
+	/// asum(a, n) - сумма a[0..n)
+	int array_sum(int handle, int count)
+	{
+		array_data *a = array_prefix(handle, count);
+		uint32_t s = 0;
+
+		if (a->type == INT)
+			return kernels().sum(a->ints, count);
+		for (int i = 0; i < count; i++)
+			s += (uint32_t)a->get(i);
+		return (int)s;
+	}
+	/// adot(a, b, n) - сумма a[i] * b[i]
+	int array_dot(int first, int second, int count)
+	{
+		array_data *a = array_prefix(first, count), *b = array_prefix(second, count);
+		uint32_t s = 0;
+
+		if (a->type == INT && b->type == INT)
+			return kernels().dot(a->ints, b->ints, count);
+		for (int i = 0; i < count; i++)
+			s += (uint32_t)a->get(i) * (uint32_t)b->get(i);
+		return (int)s;
+	}
+	/// amin(a, n) и amax(a, n), n > 0
+	int array_min(int handle, int count)
+	{
+		array_data *a = array_prefix(handle, count, 1);
+		int m;
+
+		if (a->type == INT)
+			return kernels().min(a->ints, count);
+		m = a->get(0);
+		for (int i = 1; i < count; i++)
+			m = std::min(m, a->get(i));
+		return m;
+	}
+	int array_max(int handle, int count)
+	{
+		array_data *a = array_prefix(handle, count, 1);
+		int m;
+
+		if (a->type == INT)
+			return kernels().max(a->ints, count);
+		m = a->get(0);
+		for (int i = 1; i < count; i++)
+			m = std::max(m, a->get(i));
+		return m;
+	}
+	/**
+	 * Ядра для массивов: векторные, а пока массивы делят задачи - атомарные
+	 */
+	const array_kernels &kernels() const
+	{
+		return sharing_tasks ? array_kernels::shared() : array_kernels::selected();
+	}
+	/// afill(a, v, n) - a[0..n) = v, вернуть n
+	int array_fill(int handle, int value, int count)
+	{
+		array_data *a = array_prefix(handle, count);
+
+		if (a->type == INT)
+			kernels().fill(a->ints, value, count);
+		else if (a->type == CHAR && !sharing_tasks)
+			memset(a->bytes, (char)value, count);
+		else
+			for (int i = 0; i < count; i++)
+				a->set(i, value);
+		return count;
+	}
+	/// acopy(куда, откуда, n) - вернуть n. Массивы разных типов копируются с преобразованием
+	int array_copy(int to, int from, int count)
+	{
+		array_data *target = array_prefix(to, count), *source = array_prefix(from, count);
+
+		if (target->type == INT && source->type == INT)
+			kernels().copy(target->ints, source->ints, count);
+		else if (target->type == source->type && !sharing_tasks)
+			memmove(target->bytes, source->bytes, count * target->element_size());
+		else
+			for (int i = 0; i < count; i++)
+				target->set(i, source->get(i));
+		return count;
+	}
+	/// aprefix(a, n) - a[i] = a[0] + ... + a[i] на месте, вернуть сумму всех
+	int array_prefix_sum(int handle, int count)
+	{
+		array_data *a = array_prefix(handle, count);
+		uint32_t s = 0;
+
+		if (a->type == INT)
+			return kernels().prefix(a->ints, count);
+		for (int i = 0; i < count; i++)
+			a->set(i, (int)(s += (uint32_t)a->get(i)));
+		return (int)s;
+	}
+	/**
+	 * Строка по описателю
+	 */
+	array_data *string_at(int handle)
+	{
+		if (handle <= 0 || handle >= (int)arrays.size() || !arrays[handle] || arrays[handle]->type != STR)
+			runtime_error(NOT_STRING);
+		return arrays[handle].get();
+	}
+	/**
+	 * Новая строка-значение из count нулей, которая живет до следующей инструкции
+	 * @return описатель
+	 */
+	int new_string(long count)
+	{
+		int handle;
+
+		if (count < 0 || count > max_array_size)
+			runtime_error(ARRAY_SIZE);
+		handle = new_array(STR, (int)count);
+		temp_strings.push_back({handle, function_last_index_on_call_stack});
+		return handle;
+	}
+	int new_string(const char *text, int count)
+	{
+		int handle = new_string(count);
+
+		memcpy(arrays[handle]->bytes, text, count);
+		return handle;
+	}
+	/**
+	 * Скопировать текст строки from в ячейку переменной to
+	 * @return to
+	 */
+	int copy_string(int from, int to)
+	{
+		array_data *source = string_at(from);
+
+		string_at(to)->assign(source->bytes, source->length);
+		return to;
+	}
+	/**
+	 * Строки кадра освобождаются при возврате, поэтому результат функции
+	 * string - копия, которая живет до конца инструкции вызывающего
+	 */
+	int return_string(int handle)
+	{
+		array_data *source = string_at(handle);
+		int copy;
+
+		copy = new_string(source->bytes, source->length);
+		temp_strings.back().depth = function_last_index_on_call_stack - 1;
+		return copy;
+	}
+	/**
+	 * Освободить строки-значения с глубины depth и глубже
+	 */
+	void release_temp_strings(int depth)
+	{
+		size_t kept = 0;
+
+		for (temp_string &temp : temp_strings)
+			if (temp.depth >= depth)
+			{
+				arrays[temp.handle].reset();
+				free_arrays.push_back(temp.handle);
+			}
+			else
+				temp_strings[kept++] = temp;
+		temp_strings.resize(kept);
+	}
+	/// strlen(s)
+	int string_length(int handle)
+	{
+		return string_at(handle)->length;
+	}
+	/// concat(a, b) - новая строка a + b
+	int string_concat(int first, int second)
+	{
+		array_data *a = string_at(first), *b = string_at(second);
+		int handle = new_string((long)a->length + b->length);
+
+		memcpy(arrays[handle]->bytes, a->bytes, a->length);
+		memcpy(arrays[handle]->bytes + a->length, b->bytes, b->length);
+		return handle;
+	}
+	/// substr(s, from, n) - n символов с позиции from
+	int string_substr(int handle, int from, int count)
+	{
+		array_data *text = string_at(handle);
+
+		if (from < 0 || count < 0 || from > text->length || count > text->length - from)
+			runtime_error(INDEX_RANGE);
+		return new_string(text->bytes + from, count);
+	}
+	/**
+	 * find(s, t) - позиция первого вхождения t в s или -1. Кандидатов на
+	 * первый символ ищет memchr() - в libc он векторный
+	 */
+	int string_find(int haystack, int needle)
+	{
+		array_data *text = string_at(haystack), *pattern = string_at(needle);
+		const char *p, *last;
+
+		if (!pattern->length)
+			return 0;
+		if (pattern->length > text->length)
+			return -1;
+		last = text->bytes + (text->length - pattern->length);
+		for (p = text->bytes; (p = (const char *)memchr(p, pattern->bytes[0], last - p + 1)); p++)
+			if (!memcmp(p + 1, pattern->bytes + 1, pattern->length - 1))
+				return (int)(p - text->bytes);
+		return -1;
+	}
+	/// tostr(n) - десятичная запись числа
+	int string_from_number(int value)
+	{
+		char digits[16];
+		auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+
+		return new_string(digits, (int)(end - digits));
+	}
+	/// chr(c) - строка из одного символа
+	int string_from_char(int value)
+	{
+		char c = (char)value;
+
+		return new_string(&c, 1);
+	}
+	/* Чем закончился последний getnum(): INPUT_OK, INPUT_EOF или INPUT_NOT_NUMBER */
+	int instatus(void)
+	{
+		return input_status;
+	}
+
+
+	/* Поле текущей строки --each-line: field(n) - n-е поле числом, field(0) - число полей */
+	int field(int n)
+	{
+		int count = 0;
+		const char *p = current_record.c_str();
+
+		for (;;)
+		{
+			while (is_whitespace(*p))
+				p++;
+			if (!*p)
+				return n ? 0 : count;
+			if (++count == n)
+				return atoi(p);
+			while (*p && !is_whitespace(*p))
+				p++;
+		}
+	}
+	/**
+	 * Следующее число текущей строки; поле, которое не число, дает 0
+	 */
+	int next_record_number()
+	{
+		const char *start = current_record.c_str() + record_position, *p = start, *word;
+		int number = 0;
+
+		while (is_whitespace(*p))
+			p++;
+		word = p;
+		while (*p && !is_whitespace(*p))
+			p++;
+		record_position += p - start;
+		if (word == p)
+			input_status = INPUT_EOF;
+		else if (std::from_chars(word + (*word == '+' && p - word > 1), p, number).ptr == p)
+			input_status = INPUT_OK;
+		else
+		{ /* не число - поле пропущено */
+			number = 0;
+			input_status = INPUT_NOT_NUMBER;
+		}
+		return number;
+	}
+
+	/// Вывод программы копится здесь и уходит в output_to большими кусками
+	char output_buffer[OUTPUT_BUFFER_SIZE];
+	size_t output_size = 0;
+	std::shared_ptr<output_sink> output_to = std::make_shared<fd_sink>(STDOUT_FILENO);
+
+	/**
+	 * Добавить в вывод size байт. Кусок, который не влезает в буфер,
+	 * пишется вместе с буфером одним вызовом
+	 */
+	void output(const char *data, size_t size)
+	{
+		if (output_size + size <= OUTPUT_BUFFER_SIZE)
+		{
+			memcpy(output_buffer + output_size, data, size);
+			output_size += size;
+			return;
+		}
+		iovec pieces[2] = {{output_buffer, output_size}, {(void *)data, size}};
+		output_to->write(pieces, 2);
+		output_size = 0;
+	}
+	void output_char(char c)
+	{
+		if (output_size == OUTPUT_BUFFER_SIZE)
+			flush_output();
+		output_buffer[output_size++] = c;
+	}
+	void output_number(long long value)
+	{
+		char digits[24];
+		auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+
+		output(digits, end - digits);
+	}
+	/**
+	 * Отдать накопленный вывод в output_to
+	 */
+	void flush_output()
+	{
+		if (!output_size)
+			return;
+		std::cout.flush(); /* то, что уже ушло в cout, должно оказаться раньше */
+		iovec piece = {output_buffer, output_size};
+		output_to->write(&piece, 1);
+		output_size = 0;
+	}
+
+	/// Откуда программа читает ввод
+	std::shared_ptr<input_reader> input_from = std::make_shared<input_reader>(STDIN_FILENO);
+	/// Результат последнего getnum() для instatus()
+	int input_status = INPUT_OK;
+
+	/// Режим --each-line: текущая строка и где в ней следующее число для getnum()
+	bool record_mode = false;
+	std::string current_record;
+	size_t record_position = 0;
+
+	/// Встроенные функции, которые сами разбирают аргументы из кода: им нужна строка в кавычках
+	struct intern_func_type
+	{
+		const char *f_name;   /* имя функции */
+		int (LittleC::*p)(); /* указатель на функцию */
+	} intern_func[4] = {
+			{"puts", &LittleC::call_puts},
+			{"print", &LittleC::print},
+			{"spawn", &LittleC::call_spawn},
+			{"", nullptr}};
+
+	/// Функция хоста, которую программа вызывает как встроенную
+	struct native_function
+	{
+		std::string name;
+		int arity;
+		std::function<int(const int *)> call; /* аргументы уже вычислены */
+	};
+	/// Встроенные функции с числовыми аргументами, номер - value у OP_NATIVE
+	std::vector<native_function> natives;
+
+	/**
+	 * Зарегистрировать функцию хоста: указатель на функцию, лямбду или другой
+	 * вызываемый объект с аргументами, которые получаются из int, и результатом
+	 * int, char или void. Вызов из программы компилируется в OP_NATIVE: аргументы
+	 * вычисляются деревом выражения и передаются напрямую, без разбора кода.
+	 * Функция с уже занятым именем заменяется. Функция программы с тем же именем
+	 * закрывает встроенную (см. native_call()). Регистрировать до compile()/attach():
+	 * уже скомпилированные выражения хранят номер функции.
+	 * @param name
+	 * @param callable
+	 */
+	template <typename F>
+	void register_native(const std::string &name, F callable)
+	{
+		register_native(name, std::function{std::move(callable)});
+	}
+	template <typename R, typename... Args>
+	void register_native(const std::string &name, std::function<R(Args...)> callable)
+	{
+		static_assert(sizeof...(Args) <= NUM_PARAMS, "слишком много параметров");
+		static_assert((std::is_convertible_v<int, Args> && ...), "параметры встроенной функции - числа");
+		static_assert(std::is_void_v<R> || std::is_convertible_v<R, int>, "встроенная функция возвращает число");
+		native_function native{name, (int)sizeof...(Args), [callable = std::move(callable)](const int *args)
+							   { return call_native(callable, args, std::index_sequence_for<Args...>{}); }};
+		int index = native_index(name.c_str());
+
+		if (index == -1)
+			natives.push_back(std::move(native));
+		else
+			natives[index] = std::move(native);
+	}
+	/**
+	 * Вызвать callable с args[0], args[1], ...
+	 */
+	template <typename R, typename... Args, size_t... I>
+	static int call_native(const std::function<R(Args...)> &callable, const int *args, std::index_sequence<I...>)
+	{
+		if constexpr (std::is_void_v<R>)
+		{
+			callable(static_cast<Args>(args[I])...);
+			return 0;
+		}
+		else
+			return (int)callable(static_cast<Args>(args[I])...);
+	}
+	/**
+	 * Номер встроенной функции в natives или -1
+	 */
+	int native_index(const char *name)
+	{
+		for (int i = 0; i < (int)natives.size(); i++)
+			if (natives[i].name == name)
+				return i;
+		return -1;
+	}
+	/**
+	 * Номер встроенной функции, которую вызывает имя name (current_token), или -1.
+	 * Имена программы закрывают встроенные: функция программы с тем же именем
+	 * вызывается вместо встроенной, а переменная - это имя без ( следом
+	 */
+	int native_call(const char *name)
+	{
+		char *p = source_code_location;
+
+		if (find_function_in_function_table(name))
+			return -1;
+		while (is_whitespace(*p) || *p == '\r' || *p == '\n')
+			p++;
+		return *p == '(' ? native_index(name) : -1;
+	}
+	/**
+	 * Встроенные функции библиотеки Little C
+	 */
+	void register_builtins()
+	{
+		register_native("getche", [this] { return call_getche(); });
+		register_native("putch", [this](int value) { return call_putch(value); });
+		register_native("getnum", [this] { return getnum(); });
+		register_native("readnums", [this](int handle, int count) { return readnums(handle, count); });
+		register_native("instatus", [this] { return instatus(); });
+		register_native("asum", [this](int a, int n) { return array_sum(a, n); });
+		register_native("adot", [this](int a, int b, int n) { return array_dot(a, b, n); });
+		register_native("amin", [this](int a, int n) { return array_min(a, n); });
+		register_native("amax", [this](int a, int n) { return array_max(a, n); });
+		register_native("afill", [this](int a, int value, int n) { return array_fill(a, value, n); });
+		register_native("acopy", [this](int to, int from, int n) { return array_copy(to, from, n); });
+		register_native("aprefix", [this](int a, int n) { return array_prefix_sum(a, n); });
+		register_native("strlen", [this](int s) { return string_length(s); });
+		register_native("concat", [this](int a, int b) { return string_concat(a, b); });
+		register_native("substr", [this](int s, int from, int n) { return string_substr(s, from, n); });
+		register_native("find", [this](int s, int t) { return string_find(s, t); });
+		register_native("tostr", [this](int n) { return string_from_number(n); });
+		register_native("chr", [this](int c) { return string_from_char(c); });
+		register_native("field", [this](int n) { return field(n); });
+		register_native("join", [this](int handle) { return join(handle); });
+		register_native("next", [this](int handle) { return next_value(handle); });
+		register_native("done", [this](int handle) { return generator_done(handle); });
+		register_native("chan", [this](int size) { return make_channel(size); });
+		register_native("send", [this](int handle, int value) { return channel_send(handle, value); });
+		register_native("recv", [this](int handle) { return channel_recv(handle); });
+	}
+};
+
+/**
+ * Планировщик зеленых потоков: много LittleC на нескольких потоках ОС.
+ * Каждый контекст выполняется отрезками по step_budget шагов на своем стеке
+ * (suspend_on_budget), после отрезка уходит в конец очереди своего потока.
+ * Поток без работы крадет контексты из чужих очередей. Контекст, которому
+ * нечего читать (getnum, getche), не держит поток: его дескриптор ввода
+ * ставится в epoll, и контекст возвращается в очередь, когда ввод появится.
+ * У каждого контекста должен быть свой дескриптор ввода.
+ */
+class Scheduler
+{
+public:
+	/// Шагов на отрезок для контекстов, у которых step_budget не задан
+	long time_slice = 10000;
+
+	explicit Scheduler(unsigned threads = std::max(1u, std::thread::hardware_concurrency()))
+	{
+		struct epoll_event wake{};
+
+		wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		wake.events = EPOLLIN;
+		wake.data.ptr = nullptr;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &wake);
+		for (unsigned i = 0; i < threads; i++)
+			workers.push_back(std::make_unique<worker>());
+		for (unsigned i = 0; i < threads; i++)
+			threads_.emplace_back([this, i] { work(i); });
+	}
+	~Scheduler()
+	{
+		wait();
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+			wake_poller();
+		}
+		changed.notify_all();
+		for (auto &thread : threads_)
+			thread.join();
+		close(epoll_fd);
+		close(wake_fd);
+	}
+	Scheduler(const Scheduler &) = delete;
+	Scheduler &operator=(const Scheduler &) = delete;
+
+	/**
+	 * Запустить main программы контекста или функцию function с аргументами args.
+	 * Вывод и ввод контекста (output_to, input_from) настраиваются до вызова;
+	 * fiber_stack_size для десятков тысяч контекстов стоит уменьшить
+	 * @param context
+	 * @param function пусто - main
+	 * @param args
+	 * @return номер контекста для exit_code(), wait() и context()
+	 */
+	int spawn(std::unique_ptr<LittleC> context, const std::string &function = "", const std::vector<int> &args = {})
+	{
+		return spawn(std::move(context), [function, args](LittleC &started) {
+			return function.empty() ? started.run() : started.call(function, args);
+		});
+	}
+	/**
+	 * Запустить в контексте start(context). start должен выполнять программу
+	 * через resumable(), как run() и call()
+	 */
+	int spawn(std::unique_ptr<LittleC> context, std::function<int(LittleC &)> start)
+	{
+		LittleC *raw = context.get();
+		task *added;
+		int id;
+
+		if (!context->step_budget)
+			context->step_budget = time_slice;
+		context->suspend_on_budget = true;
+		context->input_from->wait_readable = [raw](int fd) { raw->wait_for_input(fd); };
+		if (!context->pool)
+			context->pool = this;
+		context->in_scheduler = context->pool == this;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			tasks.push_back(std::make_unique<task>());
+			added = tasks.back().get();
+			id = (int)tasks.size() - 1;
+			context->task_id = id;
+			added->context = std::move(context);
+			added->start = std::move(start);
+			unfinished++;
+		}
+		push(next_worker++ % workers.size(), added);
+		return id;
+	}
+	/**
+	 * Дождаться, пока все запущенные контексты закончатся
+	 */
+	void wait()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+
+		finished.wait(guard, [this] { return unfinished == 0; });
+	}
+	/**
+	 * Дождаться контекста id, не уступая поток
+	 * @return его exit_code()
+	 */
+	int wait(int id)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+
+		finished.wait(guard, [this, id] { return tasks[id]->done; });
+		return tasks[id]->exit_code;
+	}
+	/**
+	 * Освободить закончившийся контекст id; exit_code() остается
+	 */
+	void release(int id)
+	{
+		std::unique_ptr<LittleC> released;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			if (tasks[id]->done)
+				released = std::move(tasks[id]->context);
+		}
+	}
+	unsigned size() const
+	{
+		return (unsigned)workers.size();
+	}
+	/**
+	 * Вернуть в очередь контекст id, ждавший канал
+	 */
+	void wake(int id)
+	{
+		task *woken;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+
+			woken = tasks[id].get();
+		}
+		push(next_worker++ % workers.size(), woken);
+	}
+	/**
+	 * @return что вернул run() контекста (0 - отработал, 1 - ошибка) или результат функции
+	 */
+	int exit_code(int id)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		return tasks[id]->exit_code;
+	}
+	LittleC &context(int id)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		return *tasks[id]->context;
+	}
+
+private:
+	struct task
+	{
+		std::unique_ptr<LittleC> context;
+		std::function<int(LittleC &)> start;
+		bool started = false;
+		bool done = false;
+		int exit_code = 0;
+		std::vector<task *> joiners;		/* ждут его в join() */
+	};
+	/// Очередь готовых контекстов одного потока: свои берутся спереди, чужие крадутся сзади
+	struct worker
+	{
+		std::mutex lock;
+		std::deque<task *> ready;
+	};
+
+	std::vector<std::unique_ptr<worker>> workers;
+	std::vector<std::thread> threads_;
+	std::atomic<unsigned> next_worker{0};
+	/// Сколько контекстов лежит во всех очередях
+	std::atomic<int> queued{0};
+
+	/// Защищает все, что ниже
+	std::mutex lock;
+	std::condition_variable changed;		/* появилась работа или ждущий контекст */
+	std::condition_variable finished;	/* закончился контекст */
+	std::vector<std::unique_ptr<task>> tasks;
+	int waiting = 0;				/* сколько контекстов ждут ввода в epoll */
+	int unfinished = 0;
+	bool stopping = false;
+	bool polling = false;			/* какой-то поток спит в epoll_wait() */
+	int epoll_fd = -1;				/* дескрипторы ввода ждущих контекстов и wake_fd */
+	int wake_fd = -1;				/* будит epoll_wait(), когда меняется работа */
+
+	/**
+	 * Цикл потока: отрезок за отрезком, пока планировщик не остановят
+	 */
+	void work(unsigned self)
+	{
+		task *next;
+
+		while ((next = take(self)))
+			run_slice(next, self);
+	}
+	/**
+	 * Следующий контекст для потока self: свой, украденный или дождавшийся ввода
+	 * @return nullptr, если планировщик останавливается
+	 */
+	task *take(unsigned self)
+	{
+		task *next;
+
+		for (;;)
+		{
+			if ((next = pop(self)) || (next = steal(self)))
+				return next;
+
+			std::unique_lock<std::mutex> guard(lock);
+			if (stopping)
+				return nullptr;
+			if (queued > 0)
+				continue;
+			if (waiting && !polling)
+				poll_waiting(guard, self);
+			else
+				changed.wait(guard);
+		}
+	}
+	/**
+	 * Выполнить один отрезок контекста и решить, куда он пойдет дальше
+	 */
+	void run_slice(task *current, unsigned self)
+	{
+		LittleC &context = *current->context;
+		std::vector<task *> joiners;
+		int result;
+
+		result = current->started ? context.resume() : current->start(context);
+
+		current->started = true;
+		if (context.state == CONTEXT_SUSPENDED)
+		{
+			push(self, current);
+			return;
+		}
+		if (context.state == CONTEXT_BLOCKED)
+		{ /* канал мог освободиться, пока контекст уходил с потока */
+			if (!context.blocked_on->park(&context, context.blocked_sending))
+				push(self, current);
+			return;
+		}
+		if (context.state == CONTEXT_JOINING)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			task *target = tasks[context.join_task].get();
+
+			if (!target->done)
+			{ /* вернется в очередь, когда target закончится */
+				target->joiners.push_back(current);
+				return;
+			}
+			guard.unlock();
+			push(self, current);
+			return;
+		}
+		if (context.state == CONTEXT_WAITING)
+		{
+			struct epoll_event event{};
+
+			/* один раз: после срабатывания дескриптор молчит до следующего ожидания */
+			event.events = EPOLLIN | EPOLLONESHOT;
+			event.data.ptr = current;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				waiting++;
+				wake_poller();
+			}
+			if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, context.wait_fd, &event) < 0)
+				epoll_ctl(epoll_fd, EPOLL_CTL_ADD, context.wait_fd, &event);
+			changed.notify_one();
+			return;
+		}
+		/* программа закончилась, ее стек больше не нужен */
+		context.running_fiber.reset();
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			current->exit_code = result;
+			current->done = true;
+			joiners.swap(current->joiners);
+			unfinished--;
+		}
+		finished.notify_all();
+		for (task *joiner : joiners)
+			push(self, joiner);
+	}
+	/**
+	 * Ждать в epoll_wait(), пока у кого-то из ждущих не появится ввод или не
+	 * изменится работа. Дождавшиеся переходят в очередь потока self
+	 * @param guard держит lock; на время epoll_wait() отпускается
+	 */
+	void poll_waiting(std::unique_lock<std::mutex> &guard, unsigned self)
+	{
+		struct epoll_event events[64];
+		uint64_t wakeups;
+		int count;
+
+		polling = true;
+		guard.unlock();
+
+		while ((count = epoll_wait(epoll_fd, events, 64, -1)) < 0 && errno == EINTR)
+			;
+		for (int i = 0; i < count; i++)
+			if (!events[i].data.ptr && read(wake_fd, &wakeups, sizeof(wakeups)) < 0)
+				wakeups = 0;
+
+		guard.lock();
+		polling = false;
+		for (int i = 0; i < count; i++)
+			if (events[i].data.ptr)
+				waiting--;
+		guard.unlock();
+		for (int i = 0; i < count; i++)
+			if (events[i].data.ptr)
+				push(self, (task *)events[i].data.ptr);
+		guard.lock();
+	}
+	/**
+	 * Поставить контекст в конец очереди потока и разбудить свободный поток
+	 */
+	void push(unsigned index, task *current)
+	{
+		{
+			std::lock_guard<std::mutex> guard(workers[index]->lock);
+			workers[index]->ready.push_back(current);
+		}
+		queued++;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			wake_poller();
+		}
+		changed.notify_one();
+	}
+	task *pop(unsigned self)
+	{
+		std::lock_guard<std::mutex> guard(workers[self]->lock);
+		task *next;
+
+		if (workers[self]->ready.empty())
+			return nullptr;
+		next = workers[self]->ready.front();
+		workers[self]->ready.pop_front();
+		queued--;
+		return next;
+	}
+	task *steal(unsigned self)
+	{
+		task *next;
+
+		for (size_t i = 1; i < workers.size(); i++)
+		{
+			worker &victim = *workers[(self + i) % workers.size()];
+			std::lock_guard<std::mutex> guard(victim.lock);
+
+			if (victim.ready.empty())
+				continue;
+			next = victim.ready.back();
+			victim.ready.pop_back();
+			queued--;
+			return next;
+		}
+		return nullptr;
+	}
+	/**
+	 * Разбудить поток, спящий в epoll_wait(). Вызывается под lock
+	 */
+	void wake_poller()
+	{
+		uint64_t one = 1;
+
+		if (polling && write(wake_fd, &one, sizeof(one)) < 0)
+			return; /* счетчик eventfd и так не ноль - epoll_wait() проснется */
+	}
+};
+
+/**
+ * Пул для spawn() и parfor; у контекста вне планировщика он свой
+ */
+inline Scheduler &LittleC::task_pool()
+{
+	if (!pool)
+	{
+		owned_pool = pool_threads ? std::make_shared<Scheduler>(pool_threads) : std::make_shared<Scheduler>();
+		pool = owned_pool.get();
+	}
+	return *pool;
+}
+/**
+ * Контекст задачи spawn() или parfor: та же программа с копией глобальных
+ * переменных, без ввода и с тем же выводом. Встроенные функции хоста
+ * переходят в задачу как есть, поэтому должны быть потокобезопасными.
+ *
+ * Массивы у задачи и у того, кто ее запустил, общие. Элемент читается и
+ * пишется атомарно, так что одновременные записи определены: остается одно
+ * из записанных значений. Но a[i] = a[i] + 1 из двух задач - это чтение и
+ * запись по отдельности, и одно из прибавлений может потеряться; считать
+ * общий итог надо через sum() у parfor или каналы. Переменные long и string
+ * (глобальные, локальные функции с parfor, строки в аргументах spawn())
+ * задача получает копиями, как int
+ */
+inline std::unique_ptr<LittleC> LittleC::make_task_context()
+{
+	auto child = std::make_unique<LittleC>(program);
+
+	std::copy(global_values, global_values + global_variable_position, child->global_values);
+	child->arrays = arrays; /* те же массивы, а не копии */
+	for (size_t i = 1; i < arrays.size(); i++)
+		if (arrays[i] && arrays[i]->type == STR)
+		{
+			child->arrays[i] = std::make_shared<array_data>(STR, 0);
+			child->arrays[i]->assign(arrays[i]->bytes, arrays[i]->length);
+		}
+		else if (arrays[i] && arrays[i]->variable)
+		{
+			child->arrays[i] = std::make_shared<array_data>(LONG, 1);
+			child->arrays[i]->variable = true;
+			child->arrays[i]->longs[0] = arrays[i]->longs[0];
+		}
+	child->sharing_tasks = 1;
+	sharing_tasks++;
+	child->globals_ready = true;
+	child->output_to = output_to;
+	child->input_from = std::make_shared<input_reader>(-1);
+	child->inline_budget = inline_budget;
+	child->checked_arithmetic = checked_arithmetic;
+	child->max_call_depth = max_call_depth;
+	child->max_local_vars = max_local_vars;
+	child->print_errors = print_errors;
+	child->step_budget = step_budget;
+	child->fiber_stack_size = fiber_stack_size;
+	for (size_t i = child->natives.size(); i < natives.size(); i++)
+		child->natives.push_back(natives[i]);
+	child->pool = &task_pool();
+	if (!channels)
+		channels = std::make_shared<channel_table>();
+	child->channels = channels;
+	flush_output(); /* напечатанное до запуска задачи идет раньше ее вывода */
+	return child;
+}
+inline int LittleC::start_task(const std::string &function, const std::vector<int> &args)
+{
+	auto child = make_task_context();
+
+	started_tasks.push_back(pool->spawn(std::move(child), function, args));
+	return (int)started_tasks.size() - 1;
+}
+/**
+ * Дождаться задачи пула. В планировщике контекст на это время отдает поток другим
+ * @return exit_code() задачи
+ */
+inline int LittleC::wait_task(int id)
+{
+	if (in_scheduler && state == CONTEXT_RUNNING)
+	{
+		flush_output();
+		join_task = id;
+		state = CONTEXT_JOINING;
+		swapcontext(&running_fiber->script, &running_fiber->host);
+		join_task = -1;
+	}
+	return pool->wait(id);
+}
+/**
+ * После send() или recv(): разбудить одного ждущего с другой стороны канала
+ * @param target
+ * @param senders true - ждущего места, false - ждущего значения
+ */
+inline void LittleC::wake_channel(channel *target, bool senders)
+{
+	LittleC *waiter = nullptr;
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!target->waiting.load())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(target->lock);
+		auto &queue = senders ? target->senders : target->receivers;
+
+		if (!queue.empty())
+		{
+			waiter = queue.front();
+			queue.pop_front();
+			target->waiting--;
+		}
+	}
+	target->changed.notify_all();
+	if (waiter)
+		waiter->pool->wake(waiter->task_id);
+}
+/**
+ * join(описатель) - дождаться задачи spawn() и вернуть результат ее функции
+ */
+inline int LittleC::join(int handle)
+{
+	int id, result;
+
+	if (handle < 0 || handle >= (int)started_tasks.size())
+		runtime_error(PARAM_ERR);
+	id = started_tasks[handle];
+	result = wait_task(id);
+	pool->release(id);
+	if (sharing_tasks > 0)
+		sharing_tasks--;
+	return result;
+}
+/**
+ * parfor (i = a; i < b; i = i + шаг) sum(s) min(m) max(m2) { ... }
+ *
+ * Итерации независимы и выполняются задачами пула, по одной на поток. Тело
+ * видит копию переменных функции и глобальных на момент входа в parfor,
+ * записи в них пропадают, кроме переменных из sum/min/max: каждая задача
+ * копит свою часть, а после цикла части сводятся в переменную. Массивы
+ * общие: a[i] = ... из тела виден после цикла (правила - у make_task_context()).
+ * Шаг - положительная константа, условие - < или <=
+ */
+inline void LittleC::exec_parfor()
+{
+	/* заголовок разбирается в простые переменные: runtime_error() делает longjmp,
+	 * и живые shared_ptr и vector на этом месте не освободились бы */
+	char variable[ID_LEN], reduction_names[NUM_PARAMS][ID_LEN];
+	int reduction_ops[NUM_PARAMS], reductions = 0;
+	int value, relop, failed = -1;
+	long long first, last, step, count;
+	char *body;
+
+	get_next_token();
+	if (*current_token != '(')
+		syntax_error(PAREN_EXPECTED);
+	get_next_token();
+	if (token_type != VARIABLE)
+		runtime_error(NOT_VAR);
+	strcpy_s(variable, ID_LEN, current_token);
+	get_next_token();
+	if (*current_token != '=')
+		runtime_error(EQUALS_EXPECTED);
+	eval_expression(&value);
+	first = value;
+	if (*current_token != ';')
+		runtime_error(SEMICOLON_EXPECTED);
+	source_code_location++; /* get past the ; */
+
+	get_next_token();
+	if (strcmp(variable, current_token))
+		runtime_error(SYNTAX);
+	get_next_token();
+	relop = *current_token;
+	if (relop != LOWER && relop != LOWER_OR_EQUAL)
+		runtime_error(SYNTAX);
+	eval_expression(&value);
+	last = value;
+	if (*current_token != ';')
+		runtime_error(SEMICOLON_EXPECTED);
+	source_code_location++;
+
+	/* шаг: i = i + константа */
+	get_next_token();
+	if (strcmp(variable, current_token))
+		runtime_error(SYNTAX);
+	get_next_token();
+	if (*current_token != '=')
+		runtime_error(EQUALS_EXPECTED);
+	get_next_token();
+	if (strcmp(variable, current_token))
+		runtime_error(SYNTAX);
+	get_next_token();
+	if (*current_token != '+')
+		runtime_error(SYNTAX);
+	get_next_token();
+	if (token_type != NUMBER || atoi(current_token) <= 0)
+		runtime_error(SYNTAX);
+	step = atoi(current_token);
+	get_next_token();
+	if (*current_token != ')')
+		runtime_error(PAREN_EXPECTED);
+
+	/* sum(переменная), min(...), max(...) до тела */
+	for (;;)
+	{
+		get_next_token();
+		if (token_type != VARIABLE)
+			break;
+		if (!strcmp(current_token, "sum"))
+			value = REDUCE_SUM;
+		else if (!strcmp(current_token, "min"))
+			value = REDUCE_MIN;
+		else if (!strcmp(current_token, "max"))
+			value = REDUCE_MAX;
+		else
+			runtime_error(SYNTAX);
+		get_next_token();
+		if (*current_token != '(')
+			runtime_error(PAREN_EXPECTED);
+		get_next_token();
+		if (!lookup_var(known_variable_id(current_token)))
+			runtime_error(NOT_VAR);
+		if (variable_type_of(known_variable_id(current_token)) == LONG ||
+			variable_type_of(known_variable_id(current_token)) == ARRAY)
+			runtime_error(NOT_INT);
+		if (reductions == NUM_PARAMS)
+			runtime_error(PARAM_ERR);
+		strcpy_s(reduction_names[reductions], ID_LEN, current_token);
+		reduction_ops[reductions++] = value;
+		get_next_token();
+		if (*current_token != ')')
+			runtime_error(PAREN_EXPECTED);
+	}
+	if (*current_token != '{')
+		runtime_error(UNBAL_BRACES);
+	shift_source_code_location_back();
+	body = source_code_location;
+
+	if (relop == LOWER)
+		count = first < last ? (last - first + step - 1) / step : 0;
+	else
+		count = first <= last ? (last - first) / step + 1 : 0;
+
+	if (count > 0)
+	{
+		auto loop = std::make_shared<parfor_loop>();
+		std::vector<int> ids;
+
+		loop->body = body;
+		loop->variable = variable;
+		loop->first = first;
+		loop->step = step;
+		loop->count = count;
+		for (int i = 0; i < reductions; i++)
+			loop->reductions.emplace_back(reduction_names[i], reduction_ops[i]);
+		loop->workers = (unsigned)std::min<long long>(task_pool().size(), count);
+		loop->partial.assign(loop->workers * reductions, 0);
+		for (int k = frame_base(); k < lvartos; k++)
+			if (local_var_stack[k].name_id >= 0)
+				loop->locals.push_back({variable_names[local_var_stack[k].name_id],
+										local_var_stack[k].variable_type, local_values[k]});
+		for (unsigned slot = 0; slot < loop->workers; slot++)
+			ids.push_back(pool->spawn(make_task_context(), [loop, slot](LittleC &task) {
+				return task.run_parfor_chunks(loop, slot);
+			}));
+		for (int id : ids)
+		{
+			if (wait_task(id) && failed < 0)
+				failed = pool->context(id).last_error;
+			pool->release(id);
+			sharing_tasks--;
+		}
+
+		if (failed < 0)
+			for (unsigned slot = 0; slot < loop->workers; slot++)
+				for (int i = 0; i < reductions; i++)
+				{
+					int *total = find_var_slot(known_variable_id(reduction_names[i]));
+					int part = loop->partial[slot * reductions + i];
+
+					if (reduction_ops[i] == REDUCE_SUM)
+						*total += part;
+					else if (reduction_ops[i] == REDUCE_MIN)
+						*total = std::min(*total, part);
+					else
+						*total = std::max(*total, part);
+				}
+	}
+	if (failed >= 0)
+	{ /* задача уже напечатала ошибку; loop и ids к этому месту освобождены */
+		last_error = failed;
+		longjmp(execution_buffer, RUN_ABORTED);
+	}
+	/* переменная цикла - как после обычного for */
+	*find_var_slot(known_variable_id(variable)) = (int)(first + count * step);
+	source_code_location = body;
+	find_eob();
+}
+
+class Parser
+{
+public:
+
+};
+
+} // namespace littlec
+
+using littlec::LittleC;
+using littlec::Scheduler;